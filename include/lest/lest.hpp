@@ -10,17 +10,14 @@
 #define LEST_LEST_HPP_INCLUDED
 
 #include <algorithm>
-#include <chrono>
+#include <exception>
 #include <functional>
-#include <iomanip>
-#include <iostream>
 #include <iterator>
 #include <limits>
-#include <random>
-#include <sstream>
+#include <memory>
+#include <ostream>
 #include <stdexcept>
 #include <string>
-#include <set>
 #include <tuple>
 #include <typeinfo>
 #include <type_traits>
@@ -28,8 +25,14 @@
 #include <vector>
 
 #include <cctype>
+#include <cerrno>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "lest_format.hpp"
 
 #define lest_MAJOR  1
 #define lest_MINOR  35
@@ -61,6 +64,89 @@
 # define lest_FEATURE_WSTRING  1
 #endif
 
+#ifndef  lest_FEATURE_SIMD
+# define lest_FEATURE_SIMD  1
+#endif
+
+#ifndef  lest_FEATURE_DIFF_THRESHOLD
+# define lest_FEATURE_DIFF_THRESHOLD  32
+#endif
+
+#ifndef  lest_FEATURE_DIFF_MISMATCHES
+# define lest_FEATURE_DIFF_MISMATCHES  5
+#endif
+
+#ifndef  lest_FEATURE_DIFF_CONTEXT
+# define lest_FEATURE_DIFF_CONTEXT  2
+#endif
+
+#ifndef  lest_FEATURE_DIFF_MAX_OUTPUT
+# define lest_FEATURE_DIFF_MAX_OUTPUT  1024
+#endif
+
+#ifndef  lest_FEATURE_PROPERTY_CASES
+# define lest_FEATURE_PROPERTY_CASES  100
+#endif
+
+#ifndef  lest_FEATURE_PROPERTY_SIZE
+# define lest_FEATURE_PROPERTY_SIZE  100
+#endif
+
+#ifndef  lest_FEATURE_PROPERTY_SHRINKS
+# define lest_FEATURE_PROPERTY_SHRINKS  1000
+#endif
+
+#ifndef  lest_FEATURE_FUZZ
+# define lest_FEATURE_FUZZ  0
+#endif
+
+#ifndef  lest_FEATURE_FUZZ_MAX_SIZE
+# define lest_FEATURE_FUZZ_MAX_SIZE  4096
+#endif
+
+#ifndef  lest_FEATURE_DATA
+# define lest_FEATURE_DATA  0
+#endif
+
+#ifndef  lest_FEATURE_PROCESS
+# define lest_FEATURE_PROCESS  0
+#endif
+
+// Split mode: all translation units define lest_CONFIG_SPLIT, exactly one of them
+// also defines lest_CONFIG_IMPLEMENT and compiles the runner, the reporter and
+// option parsing; the others only see the test macros and the decomposition:
+
+#ifndef  lest_CONFIG_IMPLEMENT
+# define lest_CONFIG_IMPLEMENT  0
+#endif
+
+#ifndef  lest_CONFIG_SPLIT
+# define lest_CONFIG_SPLIT  lest_CONFIG_IMPLEMENT
+#endif
+
+#define lest_HAVE_IMPLEMENTATION  ( ! lest_CONFIG_SPLIT || lest_CONFIG_IMPLEMENT )
+
+#if lest_CONFIG_SPLIT
+# define lest_INLINE  /*empty*/
+#else
+# define lest_INLINE  inline
+#endif
+
+#if lest_HAVE_IMPLEMENTATION
+# include <atomic>
+# include <chrono>
+# include <condition_variable>
+# include <deque>
+# include <fstream>
+# include <iomanip>
+# include <iostream>
+# include <mutex>
+# include <random>
+# include <set>
+# include <sstream>
+# include <thread>
+#endif
+
 #ifdef    lest_FEATURE_RTTI
 # define  lest__cpp_rtti  lest_FEATURE_RTTI
 #elif defined(__cpp_rtti)
@@ -71,10 +157,36 @@
 # define  lest__cpp_rtti  0
 #endif
 
-#if lest_FEATURE_REGEX_SEARCH
+#if lest_FEATURE_REGEX_SEARCH && lest_HAVE_IMPLEMENTATION
 # include <regex>
 #endif
 
+// Vector instructions for range comparison:
+
+#if lest_FEATURE_SIMD && defined(__AVX2__)
+# define lest_HAVE_AVX2  1
+#else
+# define lest_HAVE_AVX2  0
+#endif
+
+#if lest_FEATURE_SIMD && ( defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 ) )
+# define lest_HAVE_SSE2  1
+#else
+# define lest_HAVE_SSE2  0
+#endif
+
+#if lest_HAVE_IMPLEMENTATION
+# if lest_HAVE_AVX2
+#  include <immintrin.h>
+# elif lest_HAVE_SSE2
+#  include <emmintrin.h>
+# endif
+
+# if defined(_MSC_VER) && ( lest_HAVE_AVX2 || lest_HAVE_SSE2 )
+#  include <intrin.h>
+# endif
+#endif
+
 // Stringify:
 
 #define lest_STRINGIFY(  x )  lest_STRINGIFY_( x )
@@ -130,6 +242,63 @@
 #define lest_CPP17_OR_GREATER  ( lest_CPLUSPLUS >= 201703L )
 #define lest_CPP20_OR_GREATER  ( lest_CPLUSPLUS >= 202000L )
 
+// Parameters that the code of a stress test may leave unused:
+
+#if defined (__GNUC__)
+# define lest_MAYBE_UNUSED  __attribute__(( unused ))
+#elif lest_CPP17_OR_GREATER
+# define lest_MAYBE_UNUSED  [[maybe_unused]]
+#else
+# define lest_MAYBE_UNUSED  /*empty*/
+#endif
+
+// System headers, only for the features that need them: mapped files for
+// fuzz and data cases, signals for fuzzing, and processes, file descriptors
+// and thread affinity for options --bisect, --check-leaks and --pin-threads:
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+# define lest_HAVE_POSIX  1
+#else
+# define lest_HAVE_POSIX  0
+#endif
+
+#if ! lest_HAVE_POSIX && lest_FEATURE_FUZZ && lest_CPP17_OR_GREATER && lest_HAVE_IMPLEMENTATION && defined( __has_include )
+# if __has_include( <filesystem> )
+#  include <filesystem>
+#  define lest_HAVE_FILESYSTEM  1
+# endif
+#endif
+
+#ifndef  lest_HAVE_FILESYSTEM
+# define lest_HAVE_FILESYSTEM  0
+#endif
+
+#if lest_HAVE_POSIX && ( lest_FEATURE_FUZZ || lest_FEATURE_DATA ) && lest_HAVE_IMPLEMENTATION
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#if lest_HAVE_POSIX && lest_FEATURE_FUZZ && lest_HAVE_IMPLEMENTATION
+# include <dirent.h>
+# include <signal.h>
+#endif
+
+#if lest_HAVE_POSIX && lest_FEATURE_PROCESS && lest_HAVE_IMPLEMENTATION
+# include <dirent.h>
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
+
+#if defined( __linux__ ) && lest_FEATURE_PROCESS && lest_HAVE_IMPLEMENTATION
+# define lest_HAVE_PROCFS  1
+# include <pthread.h>
+# include <sched.h>
+#else
+# define lest_HAVE_PROCFS  0
+#endif
+
 #if ! defined( lest_NO_SHORT_MACRO_NAMES ) && ! defined( lest_NO_SHORT_ASSERTION_NAMES )
 # define MODULE            lest_MODULE
 
@@ -137,18 +306,27 @@
 #  define CASE             lest_CASE
 #  define CASE_ON          lest_CASE_ON
 #  define SCENARIO         lest_SCENARIO
+#  define PROPERTY         lest_PROPERTY
+#  define FUZZ_CASE        lest_FUZZ_CASE
+#  define DATA_CASE        lest_DATA_CASE
+#  define RECORD_CASE      lest_RECORD_CASE
 # endif
 
 # define SETUP             lest_SETUP
+# define SETUP_SHARED      lest_SETUP_SHARED
 # define SECTION           lest_SECTION
+# define STRESS            lest_STRESS
 
 # define EXPECT            lest_EXPECT
 # define EXPECT_NOT        lest_EXPECT_NOT
 # define EXPECT_NO_THROW   lest_EXPECT_NO_THROW
 # define EXPECT_THROWS     lest_EXPECT_THROWS
 # define EXPECT_THROWS_AS  lest_EXPECT_THROWS_AS
+# define EXPECT_RANGE_EQ   lest_EXPECT_RANGE_EQ
+# define EXPECT_ALL_APPROX lest_EXPECT_ALL_APPROX
 
 # define GIVEN             lest_GIVEN
+# define GIVEN_SHARED      lest_GIVEN_SHARED
 # define WHEN              lest_WHEN
 # define THEN              lest_THEN
 # define AND_WHEN          lest_AND_WHEN
@@ -161,11 +339,43 @@
 #define lest_SCENARIO( sketch  )  lest_CASE(    lest::text("Scenario: ") + sketch  )
 #endif
 #define lest_GIVEN(    context )  lest_SETUP(   lest::text("   Given: ") + context )
+#define lest_GIVEN_SHARED( context, state, ... )  lest_SETUP_SHARED( lest::text("   Given: ") + context, state, __VA_ARGS__ )
 #define lest_WHEN(     story   )  lest_SECTION( lest::text("    When: ") + story   )
 #define lest_THEN(     story   )  lest_SECTION( lest::text("    Then: ") + story   )
 #define lest_AND_WHEN( story   )  lest_SECTION( lest::text("And then: ") + story   )
 #define lest_AND_THEN( story   )  lest_SECTION( lest::text("And then: ") + story   )
 
+// Cases of a feature that is off fail to compile with a message that names
+// the macro to define; in split mode, so do the cases that need the
+// implementation in a translation unit without it:
+
+#if lest_FEATURE_FUZZ && lest_HAVE_IMPLEMENTATION
+# define lest_FUZZ_OF( where )  lest::fuzz_of( where )
+#elif lest_FEATURE_FUZZ
+# define lest_FUZZ_OF( where )  lest::unavailable< lest::split_fuzz_feature<false> >()
+#else
+# define lest_FUZZ_OF( where )  lest::unavailable< lest::fuzz_feature<false> >()
+#endif
+
+#if lest_FEATURE_DATA && lest_HAVE_IMPLEMENTATION
+# define lest_DATA_OF( path, where )  lest::data_of( path, where )
+# define lest_RECORDS_OF( type, path, where )  lest::records_of<type>( path, where )
+#elif lest_FEATURE_DATA
+# define lest_DATA_OF( path, where )  lest::unavailable< lest::split_data_feature<false> >()
+# define lest_RECORDS_OF( type, path, where )  lest::unavailable< lest::split_data_feature<false> >()
+#else
+# define lest_DATA_OF( path, where )  lest::unavailable< lest::data_feature<false> >()
+# define lest_RECORDS_OF( type, path, where )  lest::unavailable< lest::data_feature<false> >()
+#endif
+
+#if lest_HAVE_IMPLEMENTATION
+# define lest_PROPERTY_OF( generator, where )  lest::property_of( generator, where )
+# define lest_STRESS_OF( env, where, expr, threads, iterations )  lest::stress( env, where, expr, threads, iterations )
+#else
+# define lest_PROPERTY_OF( generator, where )  lest::unavailable< lest::property_feature<false> >()
+# define lest_STRESS_OF( env, where, expr, threads, iterations )  lest::unavailable< lest::stress_feature<false> >()
+#endif
+
 #if lest_FEATURE_AUTO_REGISTER
 
 # define lest_CASE( specification, proposition ) \
@@ -173,6 +383,26 @@
     namespace { lest::add_test lest_REGISTRAR( specification, lest::test( proposition, lest_FUNCTION ) ); } \
     static void lest_FUNCTION( lest::env & lest_env )
 
+# define lest_PROPERTY( specification, proposition, generator ) \
+    static void lest_FUNCTION( lest::env &, lest::generated_t<decltype( generator )> const & ); \
+    namespace { lest::add_test lest_REGISTRAR( specification, lest::test( proposition, lest_PROPERTY_OF( generator, lest_LOCATION ) * lest_FUNCTION ) ); } \
+    static void lest_FUNCTION( lest::env & lest_env, lest::generated_t<decltype( generator )> const & value )
+
+# define lest_FUZZ_CASE( specification, proposition, data, size ) \
+    static void lest_FUNCTION( lest::env &, unsigned char const *, std::size_t ); \
+    namespace { lest::add_test lest_REGISTRAR( specification, lest::test( proposition, lest_FUZZ_OF( lest_LOCATION ) * lest_FUNCTION ) ); } \
+    static void lest_FUNCTION( lest::env & lest_env, unsigned char const * data, std::size_t size )
+
+# define lest_DATA_CASE( specification, proposition, path ) \
+    static void lest_FUNCTION( lest::env &, lest::data_row const & ); \
+    namespace { lest::add_test lest_REGISTRAR( specification, lest::test( proposition, lest_DATA_OF( path, lest_LOCATION ) * lest_FUNCTION ) ); } \
+    static void lest_FUNCTION( lest::env & lest_env, lest::data_row const & row )
+
+# define lest_RECORD_CASE( specification, proposition, path, type ) \
+    static void lest_FUNCTION( lest::env &, type const & ); \
+    namespace { lest::add_test lest_REGISTRAR( specification, lest::test( proposition, lest_RECORDS_OF( type, path, lest_LOCATION ) * lest_FUNCTION ) ); } \
+    static void lest_FUNCTION( lest::env & lest_env, type const & record )
+
 #else // lest_FEATURE_AUTO_REGISTER
 
 # define lest_CASE( proposition ) \
@@ -181,6 +411,18 @@
 # define lest_CASE_ON( proposition, ... ) \
     proposition, [__VA_ARGS__]( lest::env & lest_env )
 
+# define lest_PROPERTY( proposition, generator ) \
+    proposition, lest_PROPERTY_OF( generator, lest_LOCATION ) * []( lest::env & lest_env, lest::generated_t<decltype( generator )> const & value )
+
+# define lest_FUZZ_CASE( proposition, data, size ) \
+    proposition, lest_FUZZ_OF( lest_LOCATION ) * []( lest::env & lest_env, unsigned char const * data, std::size_t size )
+
+# define lest_DATA_CASE( proposition, path ) \
+    proposition, lest_DATA_OF( path, lest_LOCATION ) * []( lest::env & lest_env, lest::data_row const & row )
+
+# define lest_RECORD_CASE( proposition, path, type ) \
+    proposition, lest_RECORDS_OF( type, path, lest_LOCATION ) * []( lest::env & lest_env, type const & record )
+
 # define lest_MODULE( specification, module ) \
     namespace { lest::add_module _( specification, module ); }
 
@@ -190,12 +432,21 @@
     for ( int lest__section = 0, lest__count = 1; lest__section < lest__count; lest__count -= 0==lest__section++ ) \
        for ( lest::ctx lest__ctx_setup( lest_env, context ); lest__ctx_setup; )
 
+#define lest_SETUP_SHARED( context, state, ... ) \
+    for ( auto lest__snapshot = lest::snapshot_of( __VA_ARGS__ ); lest__snapshot.once(); ) \
+        lest_SETUP( context ) \
+            for ( auto state = lest__snapshot.fresh(); lest__snapshot.pending(); )
+
+#define lest_STRESS( threads, iterations ) \
+    lest_STRESS_OF( lest_env, lest_LOCATION, "STRESS( " #threads ", " #iterations " )", threads, iterations ) * \
+    [&]( lest_MAYBE_UNUSED int thread, lest_MAYBE_UNUSED int iteration )
+
 #define lest_SECTION( proposition ) \
     lest_SUPPRESS_WSHADOW \
-    static int lest_UNIQUE( id ) = 0; \
-    if ( lest::guard( lest_UNIQUE( id ), lest__section, lest__count ) ) \
+    static thread_local int lest_UNIQUE( id ) = 0; \
+    if ( lest::guard( lest_UNIQUE( id ), lest__section, lest__count, lest_env, proposition ) ) \
         for ( int lest__section = 0, lest__count = 1; lest__section < lest__count; lest__count -= 0==lest__section++ ) \
-            for ( lest::ctx lest__ctx_section( lest_env, proposition ); lest__ctx_section; ) \
+            for ( lest::ctx lest__ctx_section( lest_env, proposition, true ); lest__ctx_section; ) \
     lest_RESTORE_WARNINGS
 
 #define lest_EXPECT( expr ) \
@@ -205,11 +456,11 @@
             if ( lest::result score = lest_DECOMPOSE( expr ) ) \
                 throw lest::failure{ lest_LOCATION, #expr, score.decomposition }; \
             else if ( lest_env.pass() ) \
-                lest::report( lest_env.os, lest::passing{ lest_LOCATION, #expr, score.decomposition, lest_env.zen() }, lest_env.context() ); \
+                lest::report( lest_env, lest::event::passed, __FILE__, __LINE__, #expr, std::move( score.decomposition ) ); \
         } \
         catch(...) \
         { \
-            lest::inform( lest_LOCATION, #expr ); \
+            lest::inform( lest_env, lest_LOCATION, #expr ); \
         } \
     } while ( lest::is_false() )
 
@@ -220,14 +471,14 @@
             if ( lest::result score = lest_DECOMPOSE( expr ) ) \
             { \
                 if ( lest_env.pass() ) \
-                    lest::report( lest_env.os, lest::passing{ lest_LOCATION, lest::not_expr( #expr ), lest::not_expr( score.decomposition ), lest_env.zen() }, lest_env.context() ); \
+                    lest::report( lest_env, lest::event::passed, __FILE__, __LINE__, #expr, std::move( score.decomposition ), true ); \
             } \
             else \
                 throw lest::failure{ lest_LOCATION, lest::not_expr( #expr ), lest::not_expr( score.decomposition ) }; \
         } \
         catch(...) \
         { \
-            lest::inform( lest_LOCATION, lest::not_expr( #expr ) ); \
+            lest::inform( lest_env, lest_LOCATION, lest::not_expr( #expr ) ); \
         } \
     } while ( lest::is_false() )
 
@@ -242,10 +493,10 @@
         } \
         catch (...) \
         { \
-            lest::inform( lest_LOCATION, #expr ); \
+            lest::inform( lest_env, lest_LOCATION, #expr ); \
         } \
         if ( lest_env.pass() ) \
-            lest::report( lest_env.os, lest::got_none( lest_LOCATION, #expr ), lest_env.context() ); \
+            lest::report( lest_env, lest::event::got_none, __FILE__, __LINE__, #expr ); \
     } while ( lest::is_false() )
 
 #define lest_EXPECT_THROWS( expr ) \
@@ -260,10 +511,10 @@
         catch (...) \
         { \
             if ( lest_env.pass() ) \
-                lest::report( lest_env.os, lest::got{ lest_LOCATION, #expr }, lest_env.context() ); \
+                lest::report( lest_env, lest::event::got, __FILE__, __LINE__, #expr ); \
             break; \
         } \
-        throw lest::expected{ lest_LOCATION, #expr }; \
+        lest::fail( lest_env, lest::expected{ lest_LOCATION, #expr } ); \
     } \
     while ( lest::is_false() )
 
@@ -279,14 +530,35 @@
         catch ( excpt & ) \
         { \
             if ( lest_env.pass() ) \
-                lest::report( lest_env.os, lest::got{ lest_LOCATION, #expr, lest::of_type( #excpt ) }, lest_env.context() ); \
+                lest::report( lest_env, lest::event::got, __FILE__, __LINE__, #expr, #excpt ); \
             break; \
         } \
         catch (...) {} \
-        throw lest::expected{ lest_LOCATION, #expr, lest::of_type( #excpt ) }; \
+        lest::fail( lest_env, lest::expected{ lest_LOCATION, #expr, lest::of_type( #excpt ) } ); \
     } \
     while ( lest::is_false() )
 
+#define lest_EXPECT_RANGE_EQ( lhs, rhs ) \
+    lest_EXPECT_RESULT( lest::range_eq( lhs, rhs ), "range_eq( " #lhs ", " #rhs " )" )
+
+#define lest_EXPECT_ALL_APPROX( actual, expected, appr ) \
+    lest_EXPECT_RESULT( lest::all_approx( actual, expected, appr ), "all_approx( " #actual ", " #expected ", " #appr " )" )
+
+#define lest_EXPECT_RESULT( score_expr, expr ) \
+    do { \
+        try \
+        { \
+            if ( lest::result score = score_expr ) \
+                throw lest::failure{ lest_LOCATION, expr, score.decomposition }; \
+            else if ( lest_env.pass() ) \
+                lest::report( lest_env, lest::event::passed, __FILE__, __LINE__, expr, std::move( score.decomposition ) ); \
+        } \
+        catch(...) \
+        { \
+            lest::inform( lest_env, lest_LOCATION, expr ); \
+        } \
+    } while ( lest::is_false() )
+
 #define lest_UNIQUE(  name       ) lest_UNIQUE2( name, __LINE__ )
 #define lest_UNIQUE2( name, line ) lest_UNIQUE3( name, line )
 #define lest_UNIQUE3( name, line ) name ## line
@@ -320,6 +592,56 @@ struct test
 
 using tests = std::vector<test>;
 
+// Stand-in for what makes a case of a macro that is unavailable here,
+// the static_assert of F tells why:
+
+template< typename F >
+struct unavailable : F
+{
+    template< typename C >
+    auto operator*( C const & ) const -> std::function<void( env & )> { return []( env & ) {}; }
+};
+
+template< bool enabled >
+struct fuzz_feature { static_assert( enabled, "FUZZ_CASE() requires lest_FEATURE_FUZZ=1" ); };
+
+template< bool enabled >
+struct data_feature { static_assert( enabled, "DATA_CASE() and RECORD_CASE() require lest_FEATURE_DATA=1" ); };
+
+template< bool enabled >
+struct split_fuzz_feature { static_assert( enabled, "FUZZ_CASE() requires the implementation: use it where lest_CONFIG_IMPLEMENT=1 or without lest_CONFIG_SPLIT" ); };
+
+template< bool enabled >
+struct split_data_feature { static_assert( enabled, "DATA_CASE() and RECORD_CASE() require the implementation: use them where lest_CONFIG_IMPLEMENT=1 or without lest_CONFIG_SPLIT" ); };
+
+template< bool enabled >
+struct property_feature { static_assert( enabled, "PROPERTY() requires the implementation: use it where lest_CONFIG_IMPLEMENT=1 or without lest_CONFIG_SPLIT" ); };
+
+template< bool enabled >
+struct stress_feature { static_assert( enabled, "STRESS() requires the implementation: use it where lest_CONFIG_IMPLEMENT=1 or without lest_CONFIG_SPLIT" ); };
+
+template< bool enabled >
+struct fixture_feature { static_assert( enabled, "lest::fixture requires the implementation: use it where lest_CONFIG_IMPLEMENT=1 or without lest_CONFIG_SPLIT" ); };
+
+class data_row;     // the row of DATA_CASE()
+
+#if ! lest_HAVE_IMPLEMENTATION
+
+// Stand-in for a suite fixture in split mode, the implementation has the real one:
+
+template< typename T >
+class fixture : fixture_feature< ! std::is_same<T, T>::value >
+{
+public:
+    template< typename F >
+    fixture( text, F ) {}
+
+    T const & operator()();
+    bool built() const;
+};
+
+#endif
+
 #if lest_FEATURE_AUTO_REGISTER
 
 struct add_test
@@ -346,7 +668,7 @@ struct add_module
 struct result
 {
     const bool passed;
-    const text decomposition;
+    text decomposition;
 
     template< typename T >
     result( T const & passed_, text decomposition_)
@@ -431,19 +753,40 @@ struct unexpected : message
     : message{ "failed: got unexpected exception", where_, expr_, note_ } {}
 };
 
-struct guard
+// Distance in units in the last place (ulp), via the integer representation:
+
+template< typename T > struct ulp_traits;
+template<> struct ulp_traits<float>  { typedef std::uint32_t type; };
+template<> struct ulp_traits<double> { typedef std::uint64_t type; };
+
+// map the sign-magnitude bit pattern onto monotonically increasing unsigned
+// integers, so that +0 and -0 coincide and neighbouring values differ by 1:
+
+template< typename T >
+auto ulp_key( T value ) -> typename ulp_traits<T>::type
 {
-    int & id;
-    int const & section;
+    typedef typename ulp_traits<T>::type U;
 
-    guard( int & id_, int const & section_, int & count )
-    : id( id_), section( section_)
-    {
-        if ( section == 0 )
-            id = count++ - 1;
-    }
-    operator bool() { return id == section; }
-};
+    U bits; std::memcpy( &bits, &value, sizeof bits );
+
+    const U sign = U(1) << ( 8 * sizeof(U) - 1 );
+    const U mask = U(0) - ( bits >> ( 8 * sizeof(U) - 1 ) );
+    const U mag  = bits & ~sign;
+
+    return sign + ( mag ^ mask ) - mask;
+}
+
+template< typename T >
+auto ulp_distance( T lhs, T rhs ) -> std::uint64_t
+{
+    if ( std::isnan( lhs ) || std::isnan( rhs ) )
+        return (std::numeric_limits<std::uint64_t>::max)();
+
+    const typename ulp_traits<T>::type a = ulp_key( lhs );
+    const typename ulp_traits<T>::type b = ulp_key( rhs );
+
+    return a > b ? a - b : b - a;
+}
 
 class approx
 {
@@ -451,7 +794,16 @@ public:
     explicit approx ( double magnitude )
     : epsilon_  { std::numeric_limits<float>::epsilon() * 100 }
     , scale_    { 1.0 }
-    , magnitude_{ magnitude } {}
+    , magnitude_{ magnitude }
+    , ulps_     { 0 }
+    , single_   { false } {}
+
+    // a float magnitude compares in ulp of single precision; a template that
+    // only takes float, so that integers still go to approx( double ):
+
+    template< typename T, typename = typename std::enable_if< std::is_same<T, float>::value >::type >
+    explicit approx ( T magnitude )
+    : approx( static_cast<double>( magnitude ) ) { single_ = true; }
 
     approx( approx const & other ) = default;
 
@@ -459,19 +811,38 @@ public:
 
     approx operator()( double new_magnitude )
     {
-        approx appr( new_magnitude );
-        appr.epsilon( epsilon_ );
-        appr.scale  ( scale_   );
-        return appr;
+        return with( approx( new_magnitude ) );
+    }
+
+    template< typename T, typename = typename std::enable_if< std::is_same<T, float>::value >::type >
+    approx operator()( T new_magnitude )
+    {
+        return with( approx( new_magnitude ) );
     }
 
     double magnitude() const { return magnitude_; }
+    double epsilon()   const { return epsilon_;   }
+    double scale()     const { return scale_;     }
+    int    ulps()      const { return ulps_;      }
 
     approx & epsilon( double epsilon ) { epsilon_ = epsilon; return *this; }
     approx & scale  ( double scale   ) { scale_   = scale;   return *this; }
+    approx & ulps   ( int    ulps    ) { ulps_    = ulps;    return *this; }
+
+    // distance in ulp of the precision of the magnitude, float or double:
+
+    std::uint64_t ulp_distance( double value ) const
+    {
+        return single_
+            ? lest::ulp_distance( static_cast<float>( value ), static_cast<float>( magnitude_ ) )
+            : lest::ulp_distance( value, magnitude_ );
+    }
 
     friend bool operator == ( double lhs, approx const & rhs )
     {
+        if ( rhs.ulps_ > 0 )
+            return rhs.ulp_distance( lhs ) <= static_cast<std::uint64_t>( rhs.ulps_ );
+
         // Thanks to Richard Harris for his help refining this formula.
         return std::abs( lhs - rhs.magnitude_ ) < rhs.epsilon_ * ( rhs.scale_ + (std::min)( std::abs( lhs ), std::abs( rhs.magnitude_ ) ) );
     }
@@ -486,30 +857,47 @@ public:
     friend bool operator >= ( approx const & lhs, double rhs ) { return lhs.magnitude_ > rhs || lhs == rhs; }
 
 private:
+    approx with( approx appr ) const
+    {
+        appr.epsilon( epsilon_ );
+        appr.scale  ( scale_   );
+        appr.ulps   ( ulps_    );
+        return appr;
+    }
+
     double epsilon_;
     double scale_;
     double magnitude_;
+    int    ulps_;
+    bool   single_;
 };
 
 inline bool is_false(           ) { return false; }
 inline bool is_true ( bool flag ) { return  flag; }
 
-inline text not_expr( text message )
+lest_INLINE text not_expr( text message );
+lest_INLINE text with_message( text message );
+lest_INLINE text of_type( text type );
+lest_INLINE void inform( location where, text expr );
+
+#if lest_HAVE_IMPLEMENTATION
+
+lest_INLINE text not_expr( text message )
 {
     return "! ( " + message + " )";
 }
 
-inline text with_message( text message )
+lest_INLINE text with_message( text message )
 {
     return "with message \"" + message + "\"";
 }
 
-inline text of_type( text type )
+lest_INLINE text of_type( text type )
 {
     return "of type " + type;
 }
 
-inline void inform( location where, text expr )
+lest_INLINE void inform( location where, text expr )
 {
     try
     {
@@ -529,13 +917,9 @@ inline void inform( location where, text expr )
     }
 }
 
-// Expression decomposition:
-
-template< typename T >
-auto make_value_string( T const & value ) -> std::string;
+#endif // lest_HAVE_IMPLEMENTATION
 
-template< typename T >
-auto make_memory_string( T const & item ) -> std::string;
+// Expression decomposition:
 
 #if lest_FEATURE_LITERAL_SUFFIX
 inline char const * sfx( char const  * txt ) { return txt; }
@@ -543,227 +927,236 @@ inline char const * sfx( char const  * txt ) { return txt; }
 inline char const * sfx( char const  *      ) { return ""; }
 #endif
 
-inline std::string transformed( char chr )
+// Appender: the single growable buffer that format_to() writes into.
+// Customize the reporting of a user-defined type by providing
+//   void format_to( lest::appender & out, type const & value );
+// in the namespace of the type or in namespace lest.
+
+class appender
 {
-    struct Tr { char chr; char const * str; } table[] =
-    {
-        {'\\', "\\\\" },
-        {'\r', "\\r"  }, {'\f', "\\f" },
-        {'\n', "\\n"  }, {'\t', "\\t" },
-    };
+public:
+    appender() {}
 
-    for ( auto tr : table )
-    {
-        if ( chr == tr.chr )
-            return tr.str;
-    }
+    appender & append( char chr                          ) { buffer_.push_back( chr );      return *this; }
+    appender & append( char const * txt                  ) { buffer_.append( txt );         return *this; }
+    appender & append( char const * txt, std::size_t size ) { buffer_.append( txt, size );   return *this; }
+    appender & append( std::string const & txt           ) { buffer_.append( txt );         return *this; }
 
-    auto unprintable = [](char c){ return 0 <= c && c < ' '; };
+    // room for size characters at the end, to be overwritten:
 
-    auto to_hex_string = [](char c)
+    char * grow( std::size_t size )
     {
-        std::ostringstream os;
-        os << "\\x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>( static_cast<unsigned char>(c) );
-        return os.str();
-    };
+        const std::size_t pos = buffer_.size();
+        buffer_.resize( pos + size );
+        return &buffer_[ pos ];
+    }
 
-    return unprintable( chr  ) ? to_hex_string( chr ) : std::string( 1, chr );
-}
+    std::size_t size() const { return buffer_.size(); }
 
-inline std::string make_tran_string( std::string const & txt ) { std::ostringstream os; for(auto c:txt) os << transformed(c); return os.str(); }
-inline std::string make_strg_string( std::string const & txt ) { return "\"" + make_tran_string(                 txt   ) + "\"" ; }
-inline std::string make_char_string(                char chr ) { return "\'" + make_tran_string( std::string( 1, chr ) ) + "\'" ; }
+    std::string const & str() const { return buffer_; }
 
-inline std::string to_string( std::nullptr_t              ) { return "nullptr"; }
-inline std::string to_string( std::string     const & txt ) { return make_strg_string( txt ); }
-#if lest_FEATURE_WSTRING
-inline std::string to_string( std::wstring    const & txt ) ;
-#endif
+    std::string release() { std::string result; result.swap( buffer_ ); return result; }
 
-inline std::string to_string( char    const * const   txt ) { return txt ? make_strg_string( txt ) : "{null string}"; }
-inline std::string to_string( char          * const   txt ) { return txt ? make_strg_string( txt ) : "{null string}"; }
-#if lest_FEATURE_WSTRING
-inline std::string to_string( wchar_t const * const   txt ) { return txt ? to_string( std::wstring( txt ) ) : "{null string}"; }
-inline std::string to_string( wchar_t       * const   txt ) { return txt ? to_string( std::wstring( txt ) ) : "{null string}"; }
-#endif
+private:
+    std::string buffer_;
+};
 
-inline std::string to_string(          bool          flag ) { return flag ? "true" : "false"; }
+// Stream buffer to let operator<<() write into an appender:
 
-inline std::string to_string(   signed short        value ) { return make_value_string( value ) ;             }
-inline std::string to_string( unsigned short        value ) { return make_value_string( value ) + sfx("u"  ); }
-inline std::string to_string(   signed   int        value ) { return make_value_string( value ) ;             }
-inline std::string to_string( unsigned   int        value ) { return make_value_string( value ) + sfx("u"  ); }
-inline std::string to_string(   signed  long        value ) { return make_value_string( value ) + sfx("l"  ); }
-inline std::string to_string( unsigned  long        value ) { return make_value_string( value ) + sfx("ul" ); }
-inline std::string to_string(   signed  long long   value ) { return make_value_string( value ) + sfx("ll" ); }
-inline std::string to_string( unsigned  long long   value ) { return make_value_string( value ) + sfx("ull"); }
-inline std::string to_string(         double        value ) { return make_value_string( value ) ;             }
-inline std::string to_string(          float        value ) { return make_value_string( value ) + sfx("f"  ); }
+class appender_buf : public std::streambuf
+{
+public:
+    explicit appender_buf( appender & out_ ) : out( out_ ) {}
 
-inline std::string to_string(   signed char           chr ) { return make_char_string( static_cast<char>( chr ) ); }
-inline std::string to_string( unsigned char           chr ) { return make_char_string( static_cast<char>( chr ) ); }
-inline std::string to_string(          char           chr ) { return make_char_string(                    chr   ); }
+protected:
+    int_type overflow( int_type chr ) override
+    {
+        if ( ! traits_type::eq_int_type( chr, traits_type::eof() ) )
+            out.append( traits_type::to_char_type( chr ) );
 
-template< typename T >
-struct is_streamable
-{
-    template< typename U >
-    static auto test( int ) -> decltype( std::declval<std::ostream &>() << std::declval<U>(), std::true_type() );
+        return traits_type::not_eof( chr );
+    }
 
-    template< typename >
-    static auto test( ... ) -> std::false_type;
+    std::streamsize xsputn( char const * txt, std::streamsize size ) override
+    {
+        out.append( txt, static_cast<std::size_t>( size ) );
+        return size;
+    }
 
-#ifdef _MSC_VER
-    enum { value = std::is_same< decltype( test<T>(0) ), std::true_type >::value };
-#else
-    static constexpr bool value = std::is_same< decltype( test<T>(0) ), std::true_type >::value;
-#endif
+private:
+    appender & out;
 };
 
-template< typename T >
-struct is_container
-{
-    template< typename U >
-    static auto test( int ) -> decltype( std::declval<U>().begin() == std::declval<U>().end(), std::true_type() );
-
-    template< typename >
-    static auto test( ... ) -> std::false_type;
+// Table-driven formatting of characters and bytes:
 
-#ifdef _MSC_VER
-    enum { value = std::is_same< decltype( test<T>(0) ), std::true_type >::value };
-#else
-    static constexpr bool value = std::is_same< decltype( test<T>(0) ), std::true_type >::value;
-#endif
-};
+inline char const * hex_digits() { return "0123456789abcdef"; }
 
-template< typename T, typename R >
-using ForEnum = typename std::enable_if< std::is_enum<T>::value, R>::type;
+lest_INLINE void append_escaped( appender & out, char const * txt, std::size_t size );
+lest_INLINE void append_quoted( appender & out, char quote, char const * txt, std::size_t size );
+lest_INLINE void append_memory( appender & out, void const * item, std::size_t size );
+lest_INLINE std::string transformed( char chr );
+lest_INLINE std::string make_tran_string( std::string const & txt );
+lest_INLINE std::string make_memory_string( void const * item, std::size_t size );
 
-template< typename T, typename R >
-using ForNonEnum = typename std::enable_if< ! std::is_enum<T>::value, R>::type;
+#if lest_HAVE_IMPLEMENTATION
 
-template< typename T, typename R >
-using ForStreamable = typename std::enable_if< is_streamable<T>::value, R>::type;
+struct escape_entry
+{
+    std::size_t size;
+    char str[4];
+};
 
-template< typename T, typename R >
-using ForNonStreamable = typename std::enable_if< ! is_streamable<T>::value, R>::type;
+struct escape_table
+{
+    escape_entry entry[256];
 
-template< typename T, typename R >
-using ForContainer = typename std::enable_if< is_container<T>::value, R>::type;
+    escape_table()
+    {
+        for ( std::size_t i = 0; i < 256; ++i )
+        {
+            escape_entry & e = entry[i];
+            const char chr   = static_cast<char>( i );
+
+            switch ( chr )
+            {
+                case '\\' : e = { 2, { '\\', '\\' } }; break;
+                case '\r' : e = { 2, { '\\', 'r'  } }; break;
+                case '\f' : e = { 2, { '\\', 'f'  } }; break;
+                case '\n' : e = { 2, { '\\', 'n'  } }; break;
+                case '\t' : e = { 2, { '\\', 't'  } }; break;
+                default:
+                    if ( i < ' ' ) e = { 4, { '\\', 'x', hex_digits()[ i >> 4 ], hex_digits()[ i & 0xf ] } };
+                    else           e = { 1, { chr } };
+            }
+        }
+    }
 
-template< typename T, typename R >
-using ForNonContainerNonPointer = typename std::enable_if< ! (is_container<T>::value || std::is_pointer<T>::value), R>::type;
+    escape_entry const & operator[]( char chr ) const { return entry[ static_cast<unsigned char>( chr ) ]; }
+};
 
-template< typename T >
-auto make_enum_string( T const & item ) -> ForNonEnum<T, std::string>
+inline escape_table const & escapes()
 {
-#if lest__cpp_rtti
-    return text("[type: ") + typeid(T).name() + "]: " + make_memory_string( item );
-#else
-    return text("[type: (no RTTI)]: ") + make_memory_string( item );
-#endif
+    static const escape_table table;
+    return table;
 }
 
-template< typename T >
-auto make_enum_string( T const & item ) -> ForEnum<T, std::string>
+lest_INLINE void append_escaped( appender & out, char const * txt, std::size_t size )
 {
-    return to_string( static_cast<typename std::underlying_type<T>::type>( item ) );
-}
+    escape_table const & table = escapes();
 
-template< typename T >
-auto make_string( T const & item ) -> ForNonStreamable<T, std::string>
-{
-    return make_enum_string( item );
-}
+    std::size_t length = 0;
+    for ( std::size_t i = 0; i < size; ++i )
+        length += table[ txt[i] ].size;
 
-template< typename T >
-auto make_string( T const & item ) -> ForStreamable<T, std::string>
-{
-    std::ostringstream os; os << item; return os.str();
+    char * pos = out.grow( length );
+    for ( std::size_t i = 0; i < size; ++i )
+    {
+        escape_entry const & e = table[ txt[i] ];
+        std::memcpy( pos, e.str, e.size );
+        pos += e.size;
+    }
 }
 
-template<typename T1, typename T2>
-auto make_string( std::pair<T1,T2> const & pair ) -> std::string
+lest_INLINE void append_quoted( appender & out, char quote, char const * txt, std::size_t size )
 {
-    std::ostringstream oss;
-    oss << "{ " << to_string( pair.first ) << ", " << to_string( pair.second ) << " }";
-    return oss.str();
+    out.append( quote ); append_escaped( out, txt, size ); out.append( quote );
 }
 
-template< typename TU, std::size_t N >
-struct make_tuple_string
+lest_INLINE void append_memory( appender & out, void const * item, std::size_t size )
 {
-    static std::string make( TU const & tuple )
+    // reverse order for little endian architectures:
+
+    auto is_little_endian = []
     {
-        std::ostringstream os;
-        os << to_string( std::get<N - 1>( tuple ) ) << ( N < std::tuple_size<TU>::value ? ", ": " ");
-        return make_tuple_string<TU, N - 1>::make( tuple ) + os.str();
-    }
-};
+        union U { int i = 1; char c[ sizeof(int) ]; };
 
-template< typename TU >
-struct make_tuple_string<TU, 0>
-{
-    static std::string make( TU const & ) { return ""; }
-};
+        return 1 != U{}.c[ sizeof(int) - 1 ];
+    };
 
-template< typename ...TS >
-auto make_string( std::tuple<TS...> const & tuple ) -> std::string
-{
-    return "{ " + make_tuple_string<std::tuple<TS...>, sizeof...(TS)>::make( tuple ) + "}";
-}
+    int i = 0, end = static_cast<int>( size ), inc = 1;
 
-template< typename T >
-inline std::string make_string( T const * ptr )
-{
-    // Note showbase affects the behavior of /integer/ output;
-    std::ostringstream os;
-    os << std::internal << std::hex << std::showbase << std::setw( 2 + 2 * sizeof(T*) ) << std::setfill('0') << reinterpret_cast<std::ptrdiff_t>( ptr );
-    return os.str();
+    if ( is_little_endian() ) { i = end - 1; end = inc = -1; }
+
+    unsigned char const * bytes = static_cast<unsigned char const *>( item );
+    char const * hex = hex_digits();
+
+    // "0x" followed by "hh " per byte:
+
+    out.append( "0x", 2 );
+
+    char * pos = out.grow( 3 * size );
+    for ( ; i != end; i += inc, pos += 3 )
+    {
+        pos[0] = hex[ bytes[i] >> 4  ];
+        pos[1] = hex[ bytes[i] & 0xf ];
+        pos[2] = ' ';
+    }
 }
 
-template< typename C, typename R >
-inline std::string make_string( R C::* ptr )
+lest_INLINE std::string transformed( char chr )
 {
-    std::ostringstream os;
-    os << std::internal << std::hex << std::showbase << std::setw( 2 + 2 * sizeof(R C::* ) ) << std::setfill('0') << ptr;
-    return os.str();
+    escape_entry const & e = escapes()[ chr ];
+    return std::string( e.str, e.size );
 }
 
-template< typename T >
-auto to_string( T const * ptr ) -> std::string
+lest_INLINE std::string make_tran_string( std::string const & txt )
 {
-    return ! ptr ? "nullptr" : make_string( ptr );
+    appender out; append_escaped( out, txt.data(), txt.size() ); return out.release();
 }
 
-template<typename C, typename R>
-auto to_string( R C::* ptr ) -> std::string
+lest_INLINE std::string make_memory_string( void const * item, std::size_t size )
 {
-    return ! ptr ? "nullptr" : make_string( ptr );
+    appender out; append_memory( out, item, size ); return out.release();
 }
 
+#endif // lest_HAVE_IMPLEMENTATION
+
 template< typename T >
-auto to_string( T const & item ) -> ForNonContainerNonPointer<T, std::string>
+void append_number( appender & out, T value, char const * suffix )
 {
-    return make_string( item );
+    char buffer[ 64 ];
+
+    out.append( buffer, static_cast<std::size_t>( format_number( buffer, buffer + sizeof buffer, value ) - buffer ) ).append( sfx( suffix ) );
 }
 
-template< typename C >
-auto to_string( C const & cont ) -> ForContainer<C, std::string>
+template< typename T >
+auto make_memory_string( T const & item ) -> std::string
 {
-    std::ostringstream os;
-    os << "{ ";
-    for ( auto & x : cont )
-    {
-        os << to_string( x ) << ", ";
-    }
-    os << "}";
-    return os.str();
+    return make_memory_string( &item, sizeof item );
 }
 
+// Built-in formatting:
+
+inline void format_to( appender & out, std::nullptr_t              ) { out.append( "nullptr" ); }
+inline void format_to( appender & out, std::string     const & txt ) { append_quoted( out, '"', txt.data(), txt.size() ); }
+inline void format_to( appender & out, char    const * const   txt ) { txt ? append_quoted( out, '"', txt, std::strlen( txt ) ) : void( out.append( "{null string}" ) ); }
+inline void format_to( appender & out, char          * const   txt ) { format_to( out, static_cast<char const *>( txt ) ); }
 #if lest_FEATURE_WSTRING
-inline
-auto to_string( std::wstring const & txt ) -> std::string
+lest_INLINE void format_to( appender & out, std::wstring    const & txt );
+inline void format_to( appender & out, wchar_t const * const   txt ) { txt ? format_to( out, std::wstring( txt ) ) : void( out.append( "{null string}" ) ); }
+inline void format_to( appender & out, wchar_t       * const   txt ) { format_to( out, static_cast<wchar_t const *>( txt ) ); }
+#endif
+
+inline void format_to( appender & out,          bool          flag ) { out.append( flag ? "true" : "false" ); }
+
+inline void format_to( appender & out,   signed short        value ) { append_number( out, value, ""    ); }
+inline void format_to( appender & out, unsigned short        value ) { append_number( out, value, "u"   ); }
+inline void format_to( appender & out,   signed   int        value ) { append_number( out, value, ""    ); }
+inline void format_to( appender & out, unsigned   int        value ) { append_number( out, value, "u"   ); }
+inline void format_to( appender & out,   signed  long        value ) { append_number( out, value, "l"   ); }
+inline void format_to( appender & out, unsigned  long        value ) { append_number( out, value, "ul"  ); }
+inline void format_to( appender & out,   signed  long long   value ) { append_number( out, value, "ll"  ); }
+inline void format_to( appender & out, unsigned  long long   value ) { append_number( out, value, "ull" ); }
+inline void format_to( appender & out,         double        value ) { append_number( out, value, ""    ); }
+inline void format_to( appender & out,          float        value ) { append_number( out, value, "f"   ); }
+
+inline void format_to( appender & out,   signed char           chr ) { append_quoted( out, '\'', reinterpret_cast<char const *>( &chr ), 1 ); }
+inline void format_to( appender & out, unsigned char           chr ) { append_quoted( out, '\'', reinterpret_cast<char const *>( &chr ), 1 ); }
+inline void format_to( appender & out,          char           chr ) { append_quoted( out, '\'', &chr, 1 ); }
+
+#if lest_HAVE_IMPLEMENTATION && lest_FEATURE_WSTRING
+
+lest_INLINE void format_to( appender & out, std::wstring const & txt )
 {
     std::string result; result.reserve( txt.size() );
 
@@ -771,481 +1164,4606 @@ auto to_string( std::wstring const & txt ) -> std::string
     {
         result += chr <= 0xff ? static_cast<char>( chr ) : '?';
     }
-    return to_string( result );
+    format_to( out, result );
 }
+
 #endif
 
 template< typename T >
-auto make_value_string( T const & value ) -> std::string
-{
-    std::ostringstream os; os << value; return os.str();
-}
-
-inline
-auto make_memory_string( void const * item, std::size_t size ) -> std::string
+struct is_streamable
 {
-    // reverse order for little endian architectures:
-
-    auto is_little_endian = []
-    {
-        union U { int i = 1; char c[ sizeof(int) ]; };
+    template< typename U >
+    static auto test( int ) -> decltype( std::declval<std::ostream &>() << std::declval<U>(), std::true_type() );
 
-        return 1 != U{}.c[ sizeof(int) - 1 ];
-    };
+    template< typename >
+    static auto test( ... ) -> std::false_type;
 
-    int i = 0, end = static_cast<int>( size ), inc = 1;
+#ifdef _MSC_VER
+    enum { value = std::is_same< decltype( test<T>(0) ), std::true_type >::value };
+#else
+    static constexpr bool value = std::is_same< decltype( test<T>(0) ), std::true_type >::value;
+#endif
+};
 
-    if ( is_little_endian() ) { i = end - 1; end = inc = -1; }
+template< typename T >
+struct is_container
+{
+    template< typename U >
+    static auto test( int ) -> decltype( std::declval<U>().begin() == std::declval<U>().end(), std::true_type() );
 
-    unsigned char const * bytes = static_cast<unsigned char const *>( item );
+    template< typename >
+    static auto test( ... ) -> std::false_type;
 
-    std::ostringstream os;
-    os << "0x" << std::setfill( '0' ) << std::hex;
-    for ( ; i != end; i += inc )
-    {
-        os << std::setw(2) << static_cast<unsigned>( bytes[i] ) << " ";
-    }
-    return os.str();
-}
+#ifdef _MSC_VER
+    enum { value = std::is_same< decltype( test<T>(0) ), std::true_type >::value };
+#else
+    static constexpr bool value = std::is_same< decltype( test<T>(0) ), std::true_type >::value;
+#endif
+};
 
 template< typename T >
-auto make_memory_string( T const & item ) -> std::string
-{
-    return make_memory_string( &item, sizeof item );
-}
+struct is_string : std::false_type {};
 
-inline
-auto to_string( approx const & appr ) -> std::string
-{
-    return to_string( appr.magnitude() );
-}
+template< typename C, typename T, typename A >
+struct is_string< std::basic_string<C, T, A> > : std::true_type {};
 
 template< typename L, typename R >
-auto to_string( L const & lhs, std::string op, R const & rhs ) -> std::string
+struct is_diffable
 {
-    std::ostringstream os; os << to_string( lhs ) << " " << op << " " << to_string( rhs ); return os.str();
-}
+    template< typename U, typename V >
+    static auto test( int ) -> decltype( *std::declval<U>().begin() == *std::declval<V>().begin(), std::true_type() );
 
-template< typename L >
-struct expression_lhs
-{
-    const L lhs;
+    template< typename, typename >
+    static auto test( ... ) -> std::false_type;
 
-    expression_lhs( L lhs_) : lhs( lhs_) {}
+#ifdef _MSC_VER
+    enum { value = is_container<L>::value && is_container<R>::value && ! is_string<L>::value && ! is_string<R>::value
+                   && std::is_same< decltype( test<L, R>(0) ), std::true_type >::value };
+#else
+    static constexpr bool value = is_container<L>::value && is_container<R>::value && ! is_string<L>::value && ! is_string<R>::value
+                   && std::is_same< decltype( test<L, R>(0) ), std::true_type >::value;
+#endif
+};
 
-    operator result() { return result{ !!lhs, to_string( lhs ) }; }
+// Detect a to_string() for a user-defined type via argument-dependent lookup,
+// or in namespace lest as declared before including lest; the local to_string()
+// hides lest's own and loses from, or is ambiguous with, anything more specific:
 
-    template< typename R > result operator==( R const & rhs ) { return result{ lhs == rhs, to_string( lhs, "==", rhs ) }; }
-    template< typename R > result operator!=( R const & rhs ) { return result{ lhs != rhs, to_string( lhs, "!=", rhs ) }; }
-    template< typename R > result operator< ( R const & rhs ) { return result{ lhs <  rhs, to_string( lhs, "<" , rhs ) }; }
-    template< typename R > result operator<=( R const & rhs ) { return result{ lhs <= rhs, to_string( lhs, "<=", rhs ) }; }
-    template< typename R > result operator> ( R const & rhs ) { return result{ lhs >  rhs, to_string( lhs, ">" , rhs ) }; }
-    template< typename R > result operator>=( R const & rhs ) { return result{ lhs >= rhs, to_string( lhs, ">=", rhs ) }; }
-};
+namespace adl {
 
-struct expression_decomposer
-{
-    template <typename L>
-    expression_lhs<L const &> operator<< ( L const & operand )
-    {
-        return expression_lhs<L const &>( operand );
-    }
-};
+struct no_to_string {};
 
-// Reporter:
+} // namespace adl
 
-#if lest_FEATURE_COLOURISE
+// lest's first to_string(), never defined, so that namespace adl can refer to
+// the overloads of lest::to_string() declared up to here:
 
-inline text red  ( text words ) { return "\033[1;31m" + words + "\033[0m"; }
-inline text green( text words ) { return "\033[1;32m" + words + "\033[0m"; }
-inline text gray ( text words ) { return "\033[1;30m" + words + "\033[0m"; }
+adl::no_to_string to_string( adl::no_to_string );
 
-inline bool starts_with( text words, text with )
+namespace adl {
+
+using lest::to_string;
+
+template< typename T >
+auto to_string( T const & ) -> no_to_string;
+
+template< typename T >
+struct has_to_string
 {
-    return 0 == words.find( with );
-}
+    template< typename U >
+    static auto test( int ) -> decltype( to_string( std::declval<U const &>() ) );
 
-inline text replace( text words, text from, text to )
+    template< typename >
+    static auto test( ... ) -> no_to_string;
+
+#ifdef _MSC_VER
+    enum { value = ! std::is_same< decltype( test<T>(0) ), no_to_string >::value };
+#else
+    static constexpr bool value = ! std::is_same< decltype( test<T>(0) ), no_to_string >::value;
+#endif
+};
+
+template< typename T >
+auto call_to_string( T const & item ) -> std::string
 {
-    size_t pos = words.find( from );
-    return pos == std::string::npos ? words : words.replace( pos, from.length(), to  );
+    return to_string( item );
 }
 
-inline text colour( text words )
-{
-    if      ( starts_with( words, "failed" ) ) return replace( words, "failed", red  ( "failed" ) );
-    else if ( starts_with( words, "passed" ) ) return replace( words, "passed", green( "passed" ) );
+} // namespace adl
 
-    return replace( words, "for", gray( "for" ) );
-}
+template< typename T, typename R >
+using ForContainer = typename std::enable_if< is_container<T>::value, R>::type;
 
-inline bool is_cout( std::ostream & os ) { return &os == &std::cout; }
+template< typename T, typename R >
+using ForNonContainerNonPointer = typename std::enable_if< ! (is_container<T>::value || std::is_pointer<T>::value), R>::type;
 
-struct colourise
-{
-    const text words;
+template< typename L, typename R, typename T >
+using ForDiffable = typename std::enable_if< is_diffable<L, R>::value, T>::type;
 
-    colourise( text words )
-    : words( words ) {}
+template< typename L, typename R, typename T >
+using ForNonDiffable = typename std::enable_if< ! is_diffable<L, R>::value, T>::type;
 
-    // only colourise for std::cout, not for a stringstream as used in tests:
+// Other types, in order of preference: a user-defined to_string(), operator<<(),
+// the underlying value of an enumeration or the memory content:
 
-    std::ostream & operator()( std::ostream & os ) const
-    {
-        return is_cout( os ) ? os << colour( words ) : os << words;
-    }
-};
+template< int N >
+using format_rank = std::integral_constant<int, N>;
 
-inline std::ostream & operator<<( std::ostream & os, colourise words ) { return words( os ); }
-#else
-inline text colourise( text words ) { return words; }
-#endif
+template< typename T >
+using format_rank_of = format_rank<
+    adl::has_to_string<T>::value ? 0 : is_streamable<T>::value ? 1 : std::is_enum<T>::value ? 2 : 3 >;
 
-inline text pluralise( text word, int n )
+template< typename T >
+void format_value( appender & out, T const & item, format_rank<0> )
 {
-    return n == 1 ? word : word + "s";
+    out.append( adl::call_to_string( item ) );
 }
 
-inline std::ostream & operator<<( std::ostream & os, comment note )
+template< typename T >
+void format_value( appender & out, T const & item, format_rank<1> )
 {
-    return os << (note ? " " + note.info : "" );
+    appender_buf buf( out );
+    std::ostream os( &buf ); os << item;
 }
 
-inline std::ostream & operator<<( std::ostream & os, location where )
+template< typename T >
+void format_value( appender & out, T const & item, format_rank<2> )
 {
-#ifdef __GNUG__
-    return os << where.file << ":" << where.line;
+    format_to( out, static_cast<typename std::underlying_type<T>::type>( item ) );
+}
+
+template< typename T >
+void format_value( appender & out, T const & item, format_rank<3> )
+{
+#if lest__cpp_rtti
+    out.append( "[type: " ).append( typeid(T).name() ).append( "]: " );
 #else
-    return os << where.file << "(" << where.line << ")";
+    out.append( "[type: (no RTTI)]: " );
 #endif
+    append_memory( out, &item, sizeof item );
 }
 
-inline void report( std::ostream & os, message const & e, text test )
+template< typename T >
+auto format_to( appender & out, T const & item ) -> ForNonContainerNonPointer<T, void>
 {
-    os << e.where << ": " << colourise( e.kind ) << e.note << ": " << test << ": " << colourise( e.what() ) << std::endl;
+    format_value( out, item, format_rank_of<T>() );
 }
 
-// Test runner:
-
-#if lest_FEATURE_REGEX_SEARCH
-    inline bool search( text re, text line )
+template< typename T >
+void format_to( appender & out, T const * ptr )
+{
+    if ( ! ptr )
     {
-        return std::regex_search( line, std::regex( re ) );
+        out.append( "nullptr" );
+        return;
     }
-#else
-    inline bool search( text part, text line )
-    {
-        auto case_insensitive_equal = []( char a, char b )
-        {
-            return tolower( a ) == tolower( b );
-        };
 
-        return std::search(
-            line.begin(), line.end(),
-            part.begin(), part.end(), case_insensitive_equal ) != line.end();
-    }
-#endif
+    // "0x" followed by the zero-filled address:
 
-inline bool match( texts whats, text line )
-{
-    for ( auto & what : whats )
+    std::uintptr_t value = reinterpret_cast<std::uintptr_t>( ptr );
+
+    out.append( "0x", 2 );
+
+    char * pos = out.grow( 2 * sizeof( T * ) );
+    for ( std::size_t i = 2 * sizeof( T * ); i != 0; --i, value >>= 4 )
     {
-        if ( search( what, line ) )
-            return true;
+        pos[ i - 1 ] = hex_digits()[ value & 0xf ];
     }
-    return false;
 }
 
-inline bool select( text name, texts include )
+template< typename C, typename R >
+void format_to( appender & out, R C::* ptr )
 {
-    auto none = []( texts args ) { return args.size() == 0; };
+    if ( ! ptr )
+    {
+        out.append( "nullptr" );
+        return;
+    }
 
-#if lest_FEATURE_REGEX_SEARCH
-    auto hidden = []( text arg ){ return match( { "\\[\\..*", "\\[hide\\]" }, arg ); };
-#else
-    auto hidden = []( text arg ){ return match( { "[.", "[hide]" }, arg ); };
-#endif
+    // Note showbase affects the behavior of /integer/ output;
+    appender_buf buf( out );
+    std::ostream os( &buf );
+    os.setf( std::ios_base::internal, std::ios_base::adjustfield );
+    os.setf( std::ios_base::hex | std::ios_base::showbase, std::ios_base::basefield | std::ios_base::showbase );
+    os.width( 2 + 2 * sizeof(R C::* ) ); os.fill( '0' );
+    os << ptr;
+}
 
-    if ( none( include ) )
+template< typename C >
+auto format_to( appender & out, C const & cont ) -> ForContainer<C, void>
+{
+    out.append( "{ " );
+    for ( auto const & x : cont )
     {
-        return ! hidden( name );
+        format_to( out, x ); out.append( ", " );
     }
+    out.append( "}" );
+}
 
-    bool any = false;
-    for ( auto pos = include.rbegin(); pos != include.rend(); ++pos )
+template< typename T1, typename T2 >
+void format_to( appender & out, std::pair<T1,T2> const & pair )
+{
+    out.append( "{ " ); format_to( out, pair.first ); out.append( ", " ); format_to( out, pair.second ); out.append( " }" );
+}
+
+template< typename TU, std::size_t N, std::size_t I = 0 >
+struct format_tuple
+{
+    static void to( appender & out, TU const & tuple )
     {
-        auto & part = *pos;
+        format_to( out, std::get<I>( tuple ) ); out.append( I + 1 < N ? ", ": " " );
+        format_tuple<TU, N, I + 1>::to( out, tuple );
+    }
+};
 
-        if ( part == "@" || part == "*" )
-            return true;
+template< typename TU, std::size_t N >
+struct format_tuple<TU, N, N>
+{
+    static void to( appender &, TU const & ) {}
+};
 
-        if ( search( part, name ) )
-            return true;
+template< typename ...TS >
+void format_to( appender & out, std::tuple<TS...> const & tuple )
+{
+    out.append( "{ " ); format_tuple<std::tuple<TS...>, sizeof...(TS)>::to( out, tuple ); out.append( "}" );
+}
 
-        if ( '!' == part[0] )
+inline void format_to( appender & out, approx const & appr )
+{
+    format_to( out, appr.magnitude() );
+}
+
+// Conversion to text of any type via format_to():
+
+template< typename T >
+auto to_string( T const & item ) -> std::string
+{
+    appender out; format_to( out, item ); return out.release();
+}
+
+template< typename L, typename R >
+auto to_string( L const & lhs, std::string op, R const & rhs ) -> ForNonDiffable<L, R, std::string>
+{
+    appender out; format_to( out, lhs ); out.append( ' ' ).append( op ).append( ' ' ); format_to( out, rhs ); return out.release();
+}
+
+lest_INLINE void append_ulp_distance( appender & out, double value, approx const & appr );
+
+#if lest_HAVE_IMPLEMENTATION
+
+lest_INLINE void append_ulp_distance( appender & out, double value, approx const & appr )
+{
+    if ( appr.ulps() <= 0 )
+        return;
+
+    out.append( " (ulp distance: " ); append_number( out, appr.ulp_distance( value ), "" );
+    out.append( ", max: "          ); append_number( out, appr.ulps(), "" ); out.append( ')' );
+}
+
+#endif // lest_HAVE_IMPLEMENTATION
+
+template< typename L >
+auto to_string( L const & lhs, std::string op, approx const & rhs ) -> std::string
+{
+    appender out; format_to( out, lhs ); out.append( ' ' ).append( op ).append( ' ' ); format_to( out, rhs );
+    append_ulp_distance( out, static_cast<double>( lhs ), rhs ); return out.release();
+}
+
+template< typename R >
+auto to_string( approx const & lhs, std::string op, R const & rhs ) -> std::string
+{
+    appender out; format_to( out, lhs ); out.append( ' ' ).append( op ).append( ' ' ); format_to( out, rhs );
+    append_ulp_distance( out, static_cast<double>( rhs ), lhs ); return out.release();
+}
+
+// Mismatch-focused comparison of large containers:
+
+struct diff_window
+{
+    std::size_t first;
+    std::size_t last;
+};
+
+lest_INLINE auto make_diff_windows( std::vector<std::size_t> const & at, std::size_t size ) -> std::vector<diff_window>;
+
+#if lest_HAVE_IMPLEMENTATION
+
+lest_INLINE auto make_diff_windows( std::vector<std::size_t> const & at, std::size_t size ) -> std::vector<diff_window>
+{
+    const std::size_t context = lest_FEATURE_DIFF_CONTEXT;
+
+    std::vector<diff_window> windows;
+    for ( auto pos : at )
+    {
+        const std::size_t first = pos > context ? pos - context : 0;
+        const std::size_t last  = (std::min)( pos + context, size - 1 );
+
+        if ( ! windows.empty() && first <= windows.back().last + 1 )
+            windows.back().last = last;
+        else
+            windows.push_back( diff_window{ first, last } );
+    }
+    return windows;
+}
+
+#endif // lest_HAVE_IMPLEMENTATION
+
+// the elements of each window, in one pass over the container:
+
+template< typename C >
+auto make_window_elements( C const & cont, std::vector<diff_window> const & windows ) -> std::vector<appender>
+{
+    std::vector<appender> out( windows.size() );
+
+    std::size_t i = 0, w = 0;
+    for ( auto pos = cont.begin(); pos != cont.end() && w < windows.size(); ++pos, ++i )
+    {
+        if ( i > windows[w].last && ++w == windows.size() )
+            break;
+
+        if ( i >= windows[w].first )
         {
-            any = true;
-            if ( search( part.substr(1), name ) )
-                return false;
+            format_to( out[w], *pos ); out[w].append( ", " );
         }
-        else
+    }
+    return out;
+}
+
+// "; [first..last]: { l, ... } vs { r, ... }" per window:
+
+template< typename L, typename R >
+void append_diff_windows( appender & out, L const & lhs, R const & rhs, std::vector<diff_window> const & windows )
+{
+    const auto lw = make_window_elements( lhs, windows );
+    const auto rw = make_window_elements( rhs, windows );
+
+    for ( std::size_t w = 0; w < windows.size(); ++w )
+    {
+        out.append( "; [" ); append_number( out, windows[w].first, "" );
+        out.append( ".."  ); append_number( out, windows[w].last , "" );
+        out.append( "]: { " ).append( lw[w].str() ).append( "} vs { " ).append( rw[w].str() ).append( '}' );
+    }
+}
+
+lest_INLINE auto truncated( std::string txt, std::size_t size ) -> std::string;
+
+#if lest_HAVE_IMPLEMENTATION
+
+lest_INLINE auto truncated( std::string txt, std::size_t size ) -> std::string
+{
+    return txt.size() <= size ? txt : txt.substr( 0, size ) + "...";
+}
+
+#endif // lest_HAVE_IMPLEMENTATION
+
+template< typename L, typename R >
+auto make_diff_string( L const & lhs, std::string op, R const & rhs ) -> std::string
+{
+    const std::size_t shown = lest_FEATURE_DIFF_MISMATCHES;
+
+    std::size_t nl = 0, nr = 0, differences = 0;
+    std::vector<std::size_t> at;
+
+    auto l = lhs.begin(); auto r = rhs.begin();
+    for ( ; l != lhs.end() && r != rhs.end(); ++l, ++r, ++nl )
+    {
+        if ( ! ( *l == *r ) )
         {
-            any = false;
+            if ( at.size() < shown )
+                at.push_back( nl );
+            ++differences;
         }
     }
-    return any && ! hidden( name );
+
+    const std::size_t common = nl; nr = nl;
+    for ( ; l != lhs.end(); ++l ) ++nl;
+    for ( ; r != rhs.end(); ++r ) ++nr;
+
+    appender out;
+    out.append( "{ size: " ); append_number( out, nl, "" ); out.append( " } " ).append( op );
+    out.append( " { size: " ); append_number( out, nr, "" ); out.append( " }" );
+
+    if ( differences == 0 && nl == nr )
+        return out.release();
+
+    if ( nl != nr && at.size() < shown )
+        at.push_back( common );
+
+    out.append( ": " ); append_number( out, differences, "" ); out.append( differences == 1 ? " difference" : " differences" );
+
+    if ( nl != nr )
+    {
+        out.append( " in " ); append_number( out, common, "" ); out.append( " common elements, sizes differ" );
+    }
+
+    out.append( "; at" );
+    for ( auto pos : at )
+    {
+        out.append( " [" ); append_number( out, pos, "" ); out.append( ']' );
+    }
+
+    if ( differences + ( nl != nr ? 1u : 0u ) > at.size() )
+        out.append( " ..." );
+
+    append_diff_windows( out, lhs, rhs, make_diff_windows( at, (std::max)( nl, nr ) ) );
+
+    return truncated( out.release(), lest_FEATURE_DIFF_MAX_OUTPUT );
 }
 
-inline int indefinite( int repeat ) { return repeat == -1; }
+template< typename L, typename R >
+auto to_string( L const & lhs, std::string op, R const & rhs ) -> ForDiffable<L, R, std::string>
+{
+    const std::size_t threshold = lest_FEATURE_DIFF_THRESHOLD;
+
+    if ( static_cast<std::size_t>( std::distance( lhs.begin(), lhs.end() ) ) <= threshold &&
+         static_cast<std::size_t>( std::distance( rhs.begin(), rhs.end() ) ) <= threshold )
+    {
+        appender out; format_to( out, lhs ); out.append( ' ' ).append( op ).append( ' ' ); format_to( out, rhs ); return out.release();
+    }
+    return make_diff_string( lhs, op, rhs );
+}
 
-using seed_t = std::mt19937::result_type;
+// Range equality of contiguous data, using a vectorized first-mismatch scan:
 
-struct options
+template< typename T >
+struct range_view
 {
-    bool help    = false;
-    bool abort   = false;
-    bool count   = false;
-    bool list    = false;
-    bool tags    = false;
-    bool time    = false;
-    bool pass    = false;
-    bool zen     = false;
-    bool lexical = false;
-    bool random  = false;
-    bool verbose = false;
-    bool version = false;
-    int  repeat  = 1;
-    seed_t seed  = 0;
+    T const * first;
+    std::size_t length;
+
+    T const * begin() const { return first; }
+    T const * end()   const { return first + length; }
+    std::size_t size() const { return length; }
+};
+
+template< typename T, std::size_t N >
+auto make_range_view( T const (&arr)[N] ) -> range_view<T>
+{
+    return range_view<T>{ arr, N };
+}
+
+template< typename C >
+auto make_range_view( C const & cont ) -> range_view< typename std::remove_const< typename std::remove_pointer< decltype( cont.data() ) >::type >::type >
+{
+    return { cont.data(), cont.size() };
+}
+
+template< typename T >
+struct is_bytewise_comparable
+{
+#if lest_CPP17_OR_GREATER
+    static constexpr bool value = std::has_unique_object_representations<T>::value || std::is_pointer<T>::value;
+#else
+    static constexpr bool value = std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value;
+#endif
 };
 
-struct env
-{
-    std::ostream & os;
-    options opt;
-    text testing;
-    std::vector< text > ctx;
+// position of first differing byte, or size if none:
+
+lest_INLINE std::size_t mismatch_bytes( unsigned char const * a, unsigned char const * b, std::size_t size );
+
+#if lest_HAVE_IMPLEMENTATION
+
+inline unsigned count_trailing_zeros( unsigned mask )
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>( __builtin_ctz( mask ) );
+#elif defined(_MSC_VER) && ( lest_HAVE_AVX2 || lest_HAVE_SSE2 )
+    unsigned long index; _BitScanForward( &index, mask ); return static_cast<unsigned>( index );
+#else
+    unsigned n = 0; for ( ; ! ( mask & 1u ); mask >>= 1 ) ++n; return n;
+#endif
+}
+
+lest_INLINE std::size_t mismatch_bytes( unsigned char const * a, unsigned char const * b, std::size_t size )
+{
+    std::size_t i = 0;
+#if lest_HAVE_AVX2
+    for ( ; i + 32 <= size; i += 32 )
+    {
+        const __m256i va = _mm256_loadu_si256( reinterpret_cast<__m256i const *>( a + i ) );
+        const __m256i vb = _mm256_loadu_si256( reinterpret_cast<__m256i const *>( b + i ) );
+        const unsigned equal = static_cast<unsigned>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( va, vb ) ) );
+
+        if ( equal != 0xffffffffu )
+            return i + count_trailing_zeros( ~equal );
+    }
+#endif
+#if lest_HAVE_SSE2
+    for ( ; i + 16 <= size; i += 16 )
+    {
+        const __m128i va = _mm_loadu_si128( reinterpret_cast<__m128i const *>( a + i ) );
+        const __m128i vb = _mm_loadu_si128( reinterpret_cast<__m128i const *>( b + i ) );
+        const unsigned equal = static_cast<unsigned>( _mm_movemask_epi8( _mm_cmpeq_epi8( va, vb ) ) );
+
+        if ( equal != 0xffffu )
+            return i + count_trailing_zeros( ~equal & 0xffffu );
+    }
+#endif
+    for ( ; i < size; ++i )
+    {
+        if ( a[i] != b[i] )
+            return i;
+    }
+    return size;
+}
+
+#endif // lest_HAVE_IMPLEMENTATION
+
+template< typename T >
+auto mismatch( range_view<T> lhs, range_view<T> rhs, std::size_t from, std::size_t size )
+    -> typename std::enable_if< is_bytewise_comparable<T>::value, std::size_t>::type
+{
+    auto bytes = []( T const * p ) { return reinterpret_cast<unsigned char const *>( p ); };
+
+    return from + mismatch_bytes( bytes( lhs.first + from ), bytes( rhs.first + from ), ( size - from ) * sizeof(T) ) / sizeof(T);
+}
+
+template< typename T, typename U >
+auto mismatch( range_view<T> lhs, range_view<U> rhs, std::size_t from, std::size_t size )
+    -> typename std::enable_if< ! ( std::is_same<T, U>::value && is_bytewise_comparable<T>::value ), std::size_t>::type
+{
+    for ( ; from < size; ++from )
+    {
+        if ( ! ( lhs.first[from] == rhs.first[from] ) )
+            break;
+    }
+    return from;
+}
+
+template< typename T, typename U >
+auto range_eq( range_view<T> lhs, range_view<U> rhs ) -> result
+{
+    const std::size_t shown  = lest_FEATURE_DIFF_MISMATCHES;
+    const std::size_t common = (std::min)( lhs.size(), rhs.size() );
+
+    std::size_t differences = 0;
+    std::vector<std::size_t> at;
+
+    for ( std::size_t pos = mismatch( lhs, rhs, 0, common ); pos < common; pos = mismatch( lhs, rhs, pos + 1, common ) )
+    {
+        if ( at.size() < shown )
+            at.push_back( pos );
+        ++differences;
+    }
+
+    const bool passed = differences == 0 && lhs.size() == rhs.size();
+
+    appender out;
+    out.append( "{ size: " ); append_number( out, lhs.size(), "" );
+    out.append( " } == { size: " ); append_number( out, rhs.size(), "" ); out.append( " }" );
+
+    if ( passed )
+        return result{ passed, out.release() };
+
+    if ( lhs.size() != rhs.size() && at.size() < shown )
+        at.push_back( common );
+
+    out.append( ": " ); append_number( out, differences, "" ); out.append( differences == 1 ? " difference" : " differences" );
+
+    if ( lhs.size() != rhs.size() )
+    {
+        out.append( " in " ); append_number( out, common, "" ); out.append( " common elements, sizes differ" );
+    }
+
+    if ( ! at.empty() )
+    {
+        out.append( "; first at [" ); append_number( out, at.front(), "" ); out.append( ']' );
+    }
+
+    append_diff_windows( out, lhs, rhs, make_diff_windows( at, (std::max)( lhs.size(), rhs.size() ) ) );
+
+    return result{ passed, truncated( out.release(), lest_FEATURE_DIFF_MAX_OUTPUT ) };
+}
+
+template< typename L, typename R >
+auto range_eq( L const & lhs, R const & rhs ) -> result
+{
+    return range_eq( make_range_view( lhs ), make_range_view( rhs ) );
+}
+
+// Approximate equality of floating point ranges:
+
+struct approx_stats
+{
+    std::size_t violations = 0;
+    std::size_t nans       = 0;
+    std::size_t infs       = 0;
+    std::size_t worst      = 0;
+    double max_abs_error   = 0;
+    double max_rel_error   = 0;
+    std::uint64_t max_ulps = 0;
+};
+
+// branch-free count of violations for the common, passing case; computed in
+// double like make_approx_stats() and scalar approx, so that both agree:
+
+template< typename T, typename U >
+auto count_approx_violations( range_view<T> actual, range_view<U> expected, approx const & appr ) -> std::size_t
+{
+    const double epsilon = appr.epsilon();
+    const double scale   = appr.scale();
+
+    T const * a = actual.first;
+    U const * e = expected.first;
+
+    std::uint64_t violations = 0;
+    for ( std::size_t i = 0; i < actual.size(); ++i )
+    {
+        const double x = static_cast<double>( a[i] );
+        const double y = static_cast<double>( e[i] );
+        const double ax = std::abs( x );
+        const double ay = std::abs( y );
+        const bool equal = ( x <= y ) & ( x >= y );
+        const bool close = std::abs( x - y ) < epsilon * ( scale + ( ax < ay ? ax : ay ) );
+
+        violations += ! ( equal | close );
+    }
+    return static_cast<std::size_t>( violations );
+}
+
+// ulp variant on the integer representation, NaN is never close:
+
+template< typename T, typename U >
+auto count_ulp_violations( range_view<T> actual, range_view<U> expected, approx const & appr ) -> std::size_t
+{
+    using V = typename std::common_type<T, U>::type;
+    using N = typename ulp_traits<V>::type;
+
+    const N ulps = static_cast<N>( appr.ulps() );
+
+    T const * a = actual.first;
+    U const * e = expected.first;
+
+    N violations = 0;
+    for ( std::size_t i = 0; i < actual.size(); ++i )
+    {
+        const V x = a[i];
+        const V y = e[i];
+        const N kx = ulp_key( x );
+        const N ky = ulp_key( y );
+        const bool nan = ( x != x ) | ( y != y );
+        const bool far = ( kx > ky ? kx - ky : ky - kx ) > ulps;
+
+        violations += nan | far;
+    }
+    return static_cast<std::size_t>( violations );
+}
+
+template< typename T, typename U >
+auto make_approx_stats( range_view<T> actual, range_view<U> expected, approx const & appr ) -> approx_stats
+{
+    using V = typename std::common_type<T, U>::type;
+
+    approx_stats stats;
+    bool have_worst = false;
+
+    for ( std::size_t i = 0; i < actual.size(); ++i )
+    {
+        const double x = static_cast<double>( actual.first[i]   );
+        const double y = static_cast<double>( expected.first[i] );
+
+        const std::uint64_t ulps = ulp_distance( static_cast<V>( actual.first[i] ), static_cast<V>( expected.first[i] ) );
+
+        if ( appr.ulps() > 0 ? ulps <= static_cast<std::uint64_t>( appr.ulps() )
+                             : ( x <= y && x >= y ) || std::abs( x - y ) < appr.epsilon() * ( appr.scale() + (std::min)( std::abs( x ), std::abs( y ) ) ) )
+            continue;
+
+        ++stats.violations;
+
+        if ( std::isnan( x ) || std::isnan( y ) )
+        {
+            ++stats.nans;
+            if ( ! have_worst ) { stats.worst = i; have_worst = true; }
+            continue;
+        }
+
+        if ( std::isinf( x ) || std::isinf( y ) )
+            ++stats.infs;
+
+        const double abs_error = std::abs( x - y );
+        const double rel_error = abs_error / std::abs( y );
+
+        const bool worse = appr.ulps() > 0 ? ulps > stats.max_ulps : abs_error > stats.max_abs_error;
+
+        if ( ! have_worst || worse )
+        {
+            stats.worst = i;
+            have_worst = true;
+        }
+        stats.max_abs_error = (std::max)( stats.max_abs_error, abs_error );
+        stats.max_rel_error = (std::max)( stats.max_rel_error, rel_error );
+        stats.max_ulps      = (std::max)( stats.max_ulps, ulps );
+    }
+    return stats;
+}
+
+template< typename T, typename U >
+auto all_approx( range_view<T> actual, range_view<U> expected, approx const & appr ) -> result
+{
+    using V = typename std::common_type<T, U>::type;
+
+    static_assert( std::is_same<V, float>::value || std::is_same<V, double>::value, "all_approx() requires ranges of float or double" );
+
+    appender out;
+    appender_buf buf( out );
+    std::ostream os( &buf );
+    os << "{ size: " << actual.size() << " } == approx { size: " << expected.size() << " }";
+
+    if ( actual.size() != expected.size() )
+        return result{ false, out.str() + ": sizes differ" };
+
+    const std::size_t block = 4096;
+
+    std::size_t violations = 0;
+    for ( std::size_t pos = 0; pos < actual.size() && violations == 0; pos += block )
+    {
+        const std::size_t n = (std::min)( block, actual.size() - pos );
+        const range_view<T> a{ actual.first   + pos, n };
+        const range_view<U> e{ expected.first + pos, n };
+
+        violations = appr.ulps() > 0 ? count_ulp_violations( a, e, appr ) : count_approx_violations( a, e, appr );
+    }
+
+    if ( violations == 0 )
+        return result{ true, out.release() };
+
+    const approx_stats stats = make_approx_stats( actual, expected, appr );
+
+    os << ": " << stats.violations << ( stats.violations == 1 ? " violation" : " violations" )
+       << " (NaN: " << stats.nans << ", Inf: " << stats.infs << ")"
+       << "; max abs error: " << stats.max_abs_error
+       << ", max rel error: " << stats.max_rel_error;
+
+    if ( appr.ulps() > 0 )
+        os << ", max ulp distance: " << stats.max_ulps << " (max: " << appr.ulps() << ")";
+
+    os << "; worst at [" << stats.worst << "]: " << to_string( actual.first[stats.worst] ) << " vs " << to_string( expected.first[stats.worst] );
+
+    return result{ false, out.release() };
+}
+
+template< typename L, typename R >
+auto all_approx( L const & actual, R const & expected, approx const & appr ) -> result
+{
+    return all_approx( make_range_view( actual ), make_range_view( expected ), appr );
+}
+
+template< typename L >
+struct expression_lhs
+{
+    const L lhs;
+
+    expression_lhs( L lhs_) : lhs( lhs_) {}
+
+    operator result() { return result{ !!lhs, to_string( lhs ) }; }
+
+    template< typename R > result operator==( R const & rhs ) { return result{ lhs == rhs, to_string( lhs, "==", rhs ) }; }
+    template< typename R > result operator!=( R const & rhs ) { return result{ lhs != rhs, to_string( lhs, "!=", rhs ) }; }
+    template< typename R > result operator< ( R const & rhs ) { return result{ lhs <  rhs, to_string( lhs, "<" , rhs ) }; }
+    template< typename R > result operator<=( R const & rhs ) { return result{ lhs <= rhs, to_string( lhs, "<=", rhs ) }; }
+    template< typename R > result operator> ( R const & rhs ) { return result{ lhs >  rhs, to_string( lhs, ">" , rhs ) }; }
+    template< typename R > result operator>=( R const & rhs ) { return result{ lhs >= rhs, to_string( lhs, ">=", rhs ) }; }
+};
+
+struct expression_decomposer
+{
+    template <typename L>
+    expression_lhs<L const &> operator<< ( L const & operand )
+    {
+        return expression_lhs<L const &>( operand );
+    }
+};
+
+// Reporter:
+
+#if lest_HAVE_IMPLEMENTATION
+
+#if lest_FEATURE_COLOURISE
+
+inline text red  ( text words ) { return "\033[1;31m" + words + "\033[0m"; }
+inline text green( text words ) { return "\033[1;32m" + words + "\033[0m"; }
+inline text gray ( text words ) { return "\033[1;30m" + words + "\033[0m"; }
+
+inline bool starts_with( text words, text with )
+{
+    return 0 == words.find( with );
+}
+
+inline text replace( text words, text from, text to )
+{
+    size_t pos = words.find( from );
+    return pos == std::string::npos ? words : words.replace( pos, from.length(), to  );
+}
+
+inline text colour( text words )
+{
+    if      ( starts_with( words, "failed" ) ) return replace( words, "failed", red  ( "failed" ) );
+    else if ( starts_with( words, "passed" ) ) return replace( words, "passed", green( "passed" ) );
+
+    return replace( words, "for", gray( "for" ) );
+}
+
+inline bool is_cout( std::ostream & os ) { return &os == &std::cout; }
+
+struct colourise
+{
+    const text words;
+
+    colourise( text words )
+    : words( words ) {}
+
+    // only colourise for std::cout, not for a stringstream as used in tests:
+
+    std::ostream & operator()( std::ostream & os ) const
+    {
+        return is_cout( os ) ? os << colour( words ) : os << words;
+    }
+};
+
+inline std::ostream & operator<<( std::ostream & os, colourise words ) { return words( os ); }
+#else
+inline text colourise( text words ) { return words; }
+#endif
+
+inline text pluralise( text word, int n )
+{
+    return n == 1 ? word : word + "s";
+}
+
+inline std::ostream & operator<<( std::ostream & os, comment note )
+{
+    return os << (note ? " " + note.info : "" );
+}
+
+inline std::ostream & operator<<( std::ostream & os, location where )
+{
+#ifdef __GNUG__
+    return os << where.file << ":" << where.line;
+#else
+    return os << where.file << "(" << where.line << ")";
+#endif
+}
+
+inline void report( std::ostream & os, message const & e, text test )
+{
+    os << e.where << ": " << colourise( e.kind ) << e.note << ": " << test << ": " << colourise( e.what() ) << std::endl;
+}
+
+#endif // lest_HAVE_IMPLEMENTATION
+
+// Test name and sections at the time of an event, shared by the events
+// until the sections change:
+
+struct context_snapshot
+{
+    text testing;
+    std::vector< text > sections;   // with option --verbose
+};
+
+// Reporting events, formatted where they are written: file and expression
+// are literals, the decomposition is moved in and the context is shared;
+// failures and other messages made at runtime are carried whole:
+
+struct event
+{
+    enum kind_t { passed, passed_zen, got_none, got, line, composed };
+
+    kind_t kind;
+    bool negated;           // of EXPECT_NOT
+    char const * file;
+    int  line_;
+    char const * expr;
+    char const * type;      // of exception, or null
+    text extra;             // decomposition, or formatted line
+    std::unique_ptr<message const> content;     // of a composed event
+    std::shared_ptr<context_snapshot const> context;
+
+    event()
+    : kind( line ), negated( false ), file( "" ), line_( 0 ), expr( "" ), type( nullptr ), extra(), content(), context() {}
+
+    event( kind_t kind_, char const * file_, int line_number, char const * expr_, char const * type_, text && extra_, bool negated_ )
+    : kind( kind_), negated( negated_), file( file_), line_( line_number ), expr( expr_), type( type_), extra( std::move( extra_ ) ), content(), context() {}
+
+    explicit event( text line_text )
+    : kind( line ), negated( false ), file( "" ), line_( 0 ), expr( "" ), type( nullptr ), extra( std::move( line_text ) ), content(), context() {}
+
+    explicit event( message const & e )
+    : kind( composed ), negated( false ), file( "" ), line_( 0 ), expr( "" ), type( nullptr ), extra(), content( new message( e ) ), context() {}
+};
+
+#if lest_HAVE_IMPLEMENTATION
+
+inline text to_context( context_snapshot const & snapshot )
+{
+    text msg = snapshot.testing;
+    for ( auto const & section : snapshot.sections )
+    {
+        msg += "\n  " + section;
+    }
+    return msg;
+}
+
+// the message of a passing event:
+
+inline message to_message( event::kind_t kind, location where, text expr, text extra )
+{
+    switch ( kind )
+    {
+        case event::passed_zen: return passing( where, expr, extra, true );
+        case event::got_none:   return got_none( where, expr );
+        case event::got:        return extra.empty() ? got( where, expr ) : got( where, expr, extra );
+        default:                return passing( where, expr, extra, false );
+    }
+}
+
+inline void report( std::ostream & os, event const & e, text context )
+{
+    if ( e.kind == event::line )
+    {
+        os << e.extra;
+        return;
+    }
+
+    if ( e.kind == event::composed )
+    {
+        report( os, *e.content, context );
+        return;
+    }
+
+    report( os, to_message( e.kind, location{ e.file, e.line_ },
+        e.negated ? not_expr( e.expr  ) : text( e.expr ),
+        e.negated ? not_expr( e.extra ) : e.type ? of_type( e.type ) : e.extra ), context );
+}
+
+// Bounded lock-free queue, multiple producers, single consumer,
+// after Dmitry Vyukov's bounded MPMC queue (capacity: power of 2):
+
+template< typename T >
+class bounded_queue
+{
+public:
+    explicit bounded_queue( std::size_t capacity )
+    : mask( capacity - 1 ), cells( new cell[ capacity ] ), head( 0 ), tail( 0 )
+    {
+        for ( std::size_t i = 0; i < capacity; ++i )
+            cells[i].seq.store( i, std::memory_order_relaxed );
+    }
+
+    bounded_queue( bounded_queue const & ) = delete;
+    void operator=( bounded_queue const & ) = delete;
+
+    bool try_push( T && value )
+    {
+        std::size_t pos = tail.load( std::memory_order_relaxed );
+        cell * c;
+        for (;;)
+        {
+            c = &cells[ pos & mask ];
+            const std::ptrdiff_t dif = static_cast<std::ptrdiff_t>( c->seq.load( std::memory_order_acquire ) - pos );
+
+            if ( dif == 0 )
+            {
+                if ( tail.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                    break;
+            }
+            else if ( dif < 0 )
+                return false;
+            else
+                pos = tail.load( std::memory_order_relaxed );
+        }
+        c->value = std::move( value );
+        c->seq.store( pos + 1, std::memory_order_release );
+        return true;
+    }
+
+    // on the consumer's thread:
+
+    bool empty() const
+    {
+        const std::size_t pos = head.load( std::memory_order_relaxed );
+        return static_cast<std::ptrdiff_t>( cells[ pos & mask ].seq.load( std::memory_order_acquire ) - ( pos + 1 ) ) < 0;
+    }
+
+    bool try_pop( T & value )
+    {
+        std::size_t pos = head.load( std::memory_order_relaxed );
+        cell * c = &cells[ pos & mask ];
+
+        if ( static_cast<std::ptrdiff_t>( c->seq.load( std::memory_order_acquire ) - ( pos + 1 ) ) < 0 )
+            return false;
+
+        head.store( pos + 1, std::memory_order_relaxed );
+        value = std::move( c->value );
+        c->seq.store( pos + mask + 1, std::memory_order_release );
+        return true;
+    }
+
+private:
+    struct cell
+    {
+        std::atomic<std::size_t> seq;
+        T value;
+    };
+
+    const std::size_t mask;
+    std::unique_ptr<cell[]> cells;
+    std::atomic<std::size_t> head;
+    std::atomic<std::size_t> tail;
+};
+
+// Format and write reporting events on a background thread:
+
+class async_report
+{
+public:
+    explicit async_report( std::ostream & out, std::size_t capacity = 4096 )
+    : os( out ), queue( capacity ), done( false ), sleeping( false ), mutex(), ready(), worker( &async_report::drain, this ) {}
+
+    async_report( async_report const & ) = delete;
+    void operator=( async_report const & ) = delete;
+
+    ~async_report() { stop(); }
+
+    // wake the worker only when it waits for an event:
+
+    void push( event && e )
+    {
+        while ( ! queue.try_push( std::move( e ) ) )
+            std::this_thread::yield();
+
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+
+        if ( sleeping.load( std::memory_order_relaxed ) )
+            wake();
+    }
+
+    void stop()
+    {
+        if ( worker.joinable() )
+        {
+            done.store( true, std::memory_order_seq_cst );
+            wake();
+            worker.join();
+        }
+    }
+
+private:
+    void wake()
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        ready.notify_one();
+    }
+
+    void write( event const & e )
+    {
+        report( os, e, e.context ? to_context( *e.context ) : text() );
+    }
+
+    void drain()
+    {
+        event e;
+        for (;;)
+        {
+            while ( queue.try_pop( e ) )
+                write( e );
+
+            std::unique_lock<std::mutex> lock( mutex );
+
+            sleeping.store( true, std::memory_order_seq_cst );
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+
+            ready.wait( lock, [this]{ return ! queue.empty() || done.load( std::memory_order_seq_cst ); } );
+
+            sleeping.store( false, std::memory_order_relaxed );
+
+            if ( queue.empty() && done.load( std::memory_order_seq_cst ) )
+                return;
+        }
+    }
+
+    std::ostream & os;
+    bounded_queue<event> queue;
+    std::atomic<bool> done;
+    std::atomic<bool> sleeping;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::thread worker;
+};
+
+// Test runner:
+
+#if lest_FEATURE_REGEX_SEARCH
+    inline bool search( text re, text line )
+    {
+        return std::regex_search( line, std::regex( re ) );
+    }
+#else
+    inline bool search( text part, text line )
+    {
+        auto case_insensitive_equal = []( char a, char b )
+        {
+            return tolower( a ) == tolower( b );
+        };
+
+        return std::search(
+            line.begin(), line.end(),
+            part.begin(), part.end(), case_insensitive_equal ) != line.end();
+    }
+#endif
+
+inline bool match( texts whats, text line )
+{
+    for ( auto & what : whats )
+    {
+        if ( search( what, line ) )
+            return true;
+    }
+    return false;
+}
+
+inline bool select( text name, texts include )
+{
+    auto none = []( texts args ) { return args.size() == 0; };
+
+#if lest_FEATURE_REGEX_SEARCH
+    auto hidden = []( text arg ){ return match( { "\\[\\..*", "\\[hide\\]" }, arg ); };
+#else
+    auto hidden = []( text arg ){ return match( { "[.", "[hide]" }, arg ); };
+#endif
+
+    if ( none( include ) )
+    {
+        return ! hidden( name );
+    }
+
+    bool any = false;
+    for ( auto pos = include.rbegin(); pos != include.rend(); ++pos )
+    {
+        auto & part = *pos;
+
+        if ( part == "@" || part == "*" )
+            return true;
+
+        if ( search( part, name ) )
+            return true;
+
+        if ( '!' == part[0] )
+        {
+            any = true;
+            if ( search( part.substr(1), name ) )
+                return false;
+        }
+        else
+        {
+            any = false;
+        }
+    }
+    return any && ! hidden( name );
+}
+
+inline int indefinite( int repeat ) { return repeat == -1; }
+
+#else // lest_HAVE_IMPLEMENTATION
+
+class async_report;
+
+#endif // lest_HAVE_IMPLEMENTATION
+
+using seed_t = std::uint_fast32_t;  // std::mt19937::result_type
+
+// test and repetition to run for option --replay:
+
+struct replay_point
+{
+    bool active = false;
+    int repetition = 0;
+    std::size_t index = 0;
+    text hash;
+};
+
+struct options
+{
+    bool help    = false;
+    bool abort   = false;
+    bool count   = false;
+    bool list    = false;
+    bool tags    = false;
+    bool time    = false;
+    bool pass    = false;
+    bool zen     = false;
+    bool lexical = false;
+    bool random  = false;
+    bool verbose = false;
+    bool version = false;
+    bool async   = false;
+    bool sections = false;
+    bool pin     = false;
+    int  flaky   = 0;
+    text flaky_list;
+    bool until_fail = false;
+    text bisect;
+    bool leaks   = false;
+    replay_point replay;
+    int  repeat  = 1;
+    int  cases   = lest_FEATURE_PROPERTY_CASES;
+    int  jobs    = 1;
+    int  section_jobs = 1;
+    int  fuzz    = 0;
+    bool minimize = false;
+    text corpus;
+    text artifacts;
+    texts section;
+    seed_t seed  = 0;
+};
+
+// Assertions that fail on a thread the test started, rather than on the thread
+// that runs the test, are collected here and fail the test when it returns:
+
+struct thread_failures;
+
+struct env
+{
+    std::ostream & os;
+    options opt;
+    text testing;
+    std::vector< text > ctx;
+    std::vector< std::size_t > section_at;
+    async_report * reporter;
+    texts * listing;
+    void const * owner;     // thread_tag() of the test's thread
+    std::shared_ptr<thread_failures> threads;
+    std::shared_ptr<context_snapshot const> shared_context;
+
+    env( std::ostream & out, options option );
+
+    // a copy belongs to the thread that makes it:
+
+    env( env const & other );
+
+    env & operator()( text test );
+
+    // whether assertions throw here: on the test's thread, or on a thread that
+    // catches the failures itself, like the threads of a stress test:
+
+    bool owned() const;
+
+    static bool & adopted();
+
+    void record( message const & e );
+
+    void join();
+
+    bool abort() { return opt.abort; }
+    bool pass()  { return opt.pass; }
+    bool zen()   { return opt.zen; }
+
+    void clear();
+    void pop()   { unwind( ctx.size() - 1 ); }
+
+    void push( text proposition, bool section = false );
+
+    // back to depth, after a failure left contexts behind:
+
+    void unwind( std::size_t depth );
+
+    // whether to run a section: along option --section=a/b, all of them beyond;
+    // when listing sections, only collect those just beyond the path:
+
+    bool enter( text const & proposition );
+
+    text context();
+
+    // the context for events formatted elsewhere or on other threads, made on
+    // the test's thread when the test or its sections change:
+
+    std::shared_ptr<context_snapshot const> snapshot() const;
+
+    void publish();
+
+    // the names of the sections entered:
+
+    texts path() const;
+
+    text sections();
+};
+
+lest_INLINE void report( env & output, event::kind_t kind, location where, text expr, text extra = "" );
+lest_INLINE void report( env & output, event::kind_t kind, char const * file, int line, char const * expr, text && extra = text(), bool negated = false );
+lest_INLINE void report( env & output, event::kind_t kind, char const * file, int line, char const * expr, char const * type );
+
+#if lest_HAVE_IMPLEMENTATION
+
+struct thread_failures
+{
+    std::mutex mutex;
+    std::vector<message> failed;
+};
+
+// Reports of tests and their threads, one at a time:
+
+inline std::mutex & output_mutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+// the address of a variable of the calling thread, which identifies it:
+
+inline void const * thread_tag()
+{
+    static thread_local char tag = 0;
+    return &tag;
+}
+
+lest_INLINE env::env( std::ostream & out, options option )
+: os( out ), opt( option ), testing(), ctx(), section_at(), reporter( nullptr ), listing( nullptr )
+, owner( thread_tag() ), threads( std::make_shared<thread_failures>() ), shared_context() {}
+
+lest_INLINE env::env( env const & other )
+: os( other.os ), opt( other.opt ), testing( other.testing ), ctx( other.ctx ), section_at( other.section_at ), reporter( other.reporter ), listing( other.listing )
+, owner( thread_tag() ), threads( std::make_shared<thread_failures>() ), shared_context( other.snapshot() ) {}
+
+lest_INLINE env & env::operator()( text test )
+{
+    clear(); testing = test; owner = thread_tag(); publish(); return *this;
+}
+
+lest_INLINE bool env::owned() const
+{
+    return thread_tag() == owner || adopted();
+}
+
+lest_INLINE bool & env::adopted()
+{
+    static thread_local bool adopted_ = false;
+    return adopted_;
+}
+
+lest_INLINE void env::push( text proposition, bool section )
+{
+    if ( section )
+        section_at.push_back( ctx.size() );
+
+    ctx.emplace_back( proposition );
+
+    if ( opt.verbose )
+        publish();
+}
+
+lest_INLINE void env::unwind( std::size_t depth )
+{
+    const bool changed = ctx.size() != depth;
+
+    ctx.resize( depth );
+
+    if ( changed && opt.verbose )
+        publish();
+
+    while ( ! section_at.empty() && section_at.back() >= depth )
+        section_at.pop_back();
+}
+
+lest_INLINE text env::context()
+{
+    return testing + sections();
+}
+
+lest_INLINE std::shared_ptr<context_snapshot const> env::snapshot() const
+{
+    return std::atomic_load( &shared_context );
+}
+
+lest_INLINE void env::publish()
+{
+    std::atomic_store( &shared_context, std::shared_ptr<context_snapshot const>(
+        std::make_shared<context_snapshot>( context_snapshot{ testing, opt.verbose ? ctx : std::vector< text >() } ) ) );
+}
+
+lest_INLINE texts env::path() const
+{
+    texts result;
+    for ( auto at : section_at )
+        result.push_back( ctx[at] );
+    return result;
+}
+
+lest_INLINE text env::sections()
+{
+    if ( ! opt.verbose )
+        return "";
+
+    text msg;
+    for( auto section : ctx )
+    {
+        msg += "\n  " + section;
+    }
+    return msg;
+}
+
+lest_INLINE void env::record( message const & e )
+{
+    std::lock_guard<std::mutex> lock( threads->mutex );
+    threads->failed.push_back( e );
+}
+
+lest_INLINE void env::clear()
+{
+    ctx.clear(); section_at.clear();
+
+    std::lock_guard<std::mutex> lock( threads->mutex );
+    threads->failed.clear();
+}
+
+lest_INLINE bool env::enter( text const & proposition )
+{
+    texts const & path = opt.section;
+    const std::size_t depth = section_at.size();
+
+    if ( depth < path.size() )
+        return listing || opt.replay.active ? path[depth] == proposition : search( path[depth], proposition );
+
+    if ( listing )
+    {
+        if ( std::find( listing->begin(), listing->end(), proposition ) == listing->end() )
+            listing->push_back( proposition );
+        return false;
+    }
+    return true;
+}
+
+// the reporter thread formats the event, including its context; other
+// threads than the test's use the context it published:
+
+inline void report( env & output, event && e )
+{
+    if ( e.kind == event::passed && output.zen() )
+        e.kind = event::passed_zen;
+
+    if ( output.reporter )
+    {
+        e.context = output.snapshot();
+        output.reporter->push( std::move( e ) );
+    }
+    else if ( thread_tag() == output.owner )
+    {
+        std::lock_guard<std::mutex> lock( output_mutex() );
+        report( output.os, e, output.context() );
+    }
+    else
+    {
+        const auto snapshot = output.snapshot();
+        const text context = snapshot ? to_context( *snapshot ) : text();
+
+        std::lock_guard<std::mutex> lock( output_mutex() );
+        report( output.os, e, context );
+    }
+}
+
+lest_INLINE void report( env & output, event::kind_t kind, char const * file, int line, char const * expr, text && extra, bool negated )
+{
+    report( output, event( kind, file, line, expr, nullptr, std::move( extra ), negated ) );
+}
+
+lest_INLINE void report( env & output, event::kind_t kind, char const * file, int line, char const * expr, char const * type )
+{
+    report( output, event( kind, file, line, expr, type, text(), false ) );
+}
+
+// an event of a location and texts made at runtime:
+
+lest_INLINE void report( env & output, event::kind_t kind, location where, text expr, text extra )
+{
+    if ( kind == event::passed && output.zen() )
+        kind = event::passed_zen;
+
+    report( output, event( to_message( kind, where, expr, extra ) ) );
+}
+
+inline void report( env & output, message const & e )
+{
+    report( output, event( e ) );
+}
+
+// report all but the last failure on the test's threads, and throw that:
+
+lest_INLINE void env::join()
+{
+    std::vector<message> failed;
+    {
+        std::lock_guard<std::mutex> lock( threads->mutex );
+        failed.swap( threads->failed );
+    }
+
+    if ( failed.empty() )
+        return;
+
+    for ( std::size_t i = 0; i + 1 < failed.size(); ++i )
+        report( *this, failed[i] );
+
+    throw failed.back();
+}
+
+#endif // lest_HAVE_IMPLEMENTATION
+
+// on a thread of the test, record a failure instead of throwing it:
+
+template< typename E >
+void fail( env & output, E const & e )
+{
+    if ( output.owned() )
+        throw e;
+
+    output.record( e );
+}
+
+lest_INLINE void inform( env & output, location where, text expr );
+
+#if lest_HAVE_IMPLEMENTATION
+
+lest_INLINE void inform( env & output, location where, text expr )
+{
+    try
+    {
+        inform( where, expr );
+    }
+    catch ( message const & e )
+    {
+        if ( output.owned() )
+            throw;
+
+        output.record( e );
+    }
+}
+
+// Option --check-leaks: the file descriptors and threads of the process before
+// and after a test (Linux); a test that made a suite fixture isn't checked:
+
+#if lest_HAVE_PROCFS
+
+struct resources
+{
+    std::vector<int> fds;
+    int threads = 0;
+};
+
+// the numbered entries of dir_path; without the directory's own descriptor
+// for /proc/self/fd, where it's listed too:
+
+inline void list_entries( char const * dir_path, std::vector<int> & numbers, bool skip_own )
+{
+    if ( DIR * dir = ::opendir( dir_path ) )
+    {
+        const int own = skip_own ? ::dirfd( dir ) : -1;
+
+        while ( dirent * entry = ::readdir( dir ) )
+        {
+            if ( entry->d_name[0] != '.' && std::atoi( entry->d_name ) != own )
+                numbers.push_back( std::atoi( entry->d_name ) );
+        }
+        ::closedir( dir );
+    }
+}
+
+inline resources current_resources()
+{
+    resources result;
+    std::vector<int> tasks;
+
+    list_entries( "/proc/self/fd"  , result.fds, true  );
+    list_entries( "/proc/self/task", tasks     , false );
+
+    std::sort( result.fds.begin(), result.fds.end() );
+    result.threads = static_cast<int>( tasks.size() );
+
+    return result;
+}
+
+// a thread that was just joined may still be listed for a moment,
+// so look again for a while before taking it for a leak:
+
+inline resources settled_resources( resources const & before )
+{
+    resources result = current_resources();
+
+    for ( int retry = 0; retry < 100 && result.threads > before.threads; ++retry )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        result = current_resources();
+    }
+    return result;
+}
+
+inline text fd_target( int fd )
+{
+    char target[ 512 ];
+    const text link = "/proc/self/fd/" + to_string( fd );
+    const ssize_t size = ::readlink( link.c_str(), target, sizeof target - 1 );
+
+    return size < 0 ? text( "?" ) : text( target, static_cast<std::size_t>( size ) );
+}
+
+inline void check_leaks( resources const & before, resources const & after )
+{
+    std::vector<int> fds;
+    std::set_difference( after.fds.begin(), after.fds.end(), before.fds.begin(), before.fds.end(), std::back_inserter( fds ) );
+
+    const int threads = after.threads - before.threads;
+
+    if ( fds.empty() && threads <= 0 )
+        return;
+
+    text what, note;
+
+    if ( ! fds.empty() )
+        what = to_string( fds.size() ) + " file " + pluralise( "descriptor", static_cast<int>( fds.size() ) );
+
+    if ( threads > 0 )
+        what += ( what.empty() ? "" : ", " ) + to_string( threads ) + " " + pluralise( "thread", threads );
+
+    for ( auto fd : fds )
+        note += ( note.empty() ? "(fd " : ", fd " ) + to_string( fd ) + " -> " + fd_target( fd );
+
+    throw message{ "failed: leaked", location{ "lest", 0 }, what, note.empty() ? note : note + ")" };
+}
+
+#endif // lest_HAVE_PROCFS
+
+inline std::size_t fixture_events();
+
+// run a test, and fail it for the assertions that failed on its threads
+// and, with option --check-leaks, for the resources it left behind:
+
+inline void perform( test const & testing, env & output )
+{
+#if lest_HAVE_PROCFS
+    if ( output.opt.leaks )
+    {
+        const resources before = current_resources();
+        const std::size_t events = fixture_events();
+
+        testing.behaviour( output );
+        output.join();
+
+        if ( fixture_events() == events )
+            check_leaks( before, settled_resources( before ) );
+        return;
+    }
+#endif
+    testing.behaviour( output );
+    output.join();
+}
+
+// Start asynchronous reporting for option --async-report:
+
+inline std::unique_ptr<async_report> make_reporter( env & output )
+{
+    std::unique_ptr<async_report> result( output.opt.async ? new async_report( output.os ) : nullptr );
+    output.reporter = result.get();
+    return result;
+}
+
+#endif // lest_HAVE_IMPLEMENTATION
+
+struct ctx
+{
+    env & environment;
+    bool once;
+
+    ctx( env & environment_, text proposition_, bool section = false )
+    : environment( environment_), once( true )
+    {
+        environment.push( proposition_, section );
+    }
+
+    ~ctx()
+    {
+#if lest_CPP17_OR_GREATER
+        if ( std::uncaught_exceptions() == 0 )
+#else
+        if ( ! std::uncaught_exception() )
+#endif
+        {
+            environment.pop();
+        }
+    }
+
+    explicit operator bool() { bool result = once; once = false; return result; }
+};
+
+// State of SETUP_SHARED(), made once per run of a test; each run of the setup
+// for one of its sections gets a fresh copy:
+
+template< typename T >
+class snapshot
+{
+public:
+    explicit snapshot( T && value_ )
+    : value( new T( std::move( value_ ) ) ), live( true ), pending_( false ) {}
+
+    bool once() { bool result = live; live = false; return result; }
+
+    T fresh() { pending_ = true; return *value; }
+
+    bool pending() { bool result = pending_; pending_ = false; return result; }
+
+private:
+    std::unique_ptr<const T> value;
+    bool live;
+    bool pending_;
+};
+
+template< typename F >
+auto snapshot_of( F make ) -> snapshot< typename std::decay< decltype( make() ) >::type >
+{
+    return snapshot< typename std::decay< decltype( make() ) >::type >( make() );
+}
+
+// Number the sections of a setup or section on its first run, skipping those
+// that are not on the --section path; runs of the enclosing code are counted:
+
+struct guard
+{
+    int & id;
+    int const & section;
+
+    guard( int & id_, int const & section_, int & count, env & environment, text const & proposition )
+    : id( id_), section( section_)
+    {
+        if ( section == 0 )
+            id = environment.enter( proposition ) ? count++ - 1 : -1;
+    }
+    operator bool() { return id == section; }
+};
+
+// Property-based testing:
+
+// Random source for generated values, cheap to seed per case (splitmix64):
+
+class splitmix64
+{
+public:
+    using result_type = std::uint64_t;
+
+    explicit splitmix64( std::uint64_t seed ) : state( seed ) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return (std::numeric_limits<result_type>::max)(); }
+
+    result_type operator()()
+    {
+        std::uint64_t z = ( state += 0x9e3779b97f4a7c15ull );
+        z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+        z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+        return z ^ ( z >> 31 );
+    }
+
+    // uniform in [0, n), n > 0:
+
+    std::uint64_t below( std::uint64_t n )
+    {
+        const std::uint64_t threshold = ( ~n + 1 ) % n;
+
+        for (;;)
+        {
+            const std::uint64_t r = (*this)();
+            if ( r >= threshold )
+                return r % n;
+        }
+    }
+
+    // uniform in [0, 1):
+
+    double unit() { return static_cast<double>( (*this)() >> 11 ) * ( 1.0 / 9007199254740992.0 ); }
+
+private:
+    std::uint64_t state;
+};
+
+#if lest_HAVE_IMPLEMENTATION
+
+// independent stream per case, so that a case reproduces from its index:
+
+inline std::uint64_t case_seed( std::uint64_t seed, std::uint64_t index )
+{
+    return splitmix64( seed ^ ( index * 0xd1b54a32d192ed03ull ) )();
+}
+
+inline std::size_t case_size( std::uint64_t index )
+{
+    return static_cast<std::size_t>( index % ( lest_FEATURE_PROPERTY_SIZE + 1 ) );
+}
+
+#endif // lest_HAVE_IMPLEMENTATION
+
+template< typename T >
+bool same( T const & a, T const & b ) { return ! ( a < b ) && ! ( b < a ); }
+
+// Generators; a generator G provides:
+// - G::value_type
+// - void generate( splitmix64 & rng, std::size_t size, value_type & value ) const;
+//   overwrites value, reusing the storage it already has.
+// - template< typename F > bool shrink( value_type const & value, F && accept ) const;
+//   offers simpler candidates to accept() until it returns true; returns whether it did.
+
+namespace gen {
+
+template< typename T >
+struct integral_gen
+{
+    using value_type = T;
+
+    T lo, hi;
+
+    void generate( splitmix64 & rng, std::size_t, T & value ) const
+    {
+        const std::uint64_t span   = static_cast<std::uint64_t>( hi ) - static_cast<std::uint64_t>( lo );
+        const std::uint64_t offset = span == (std::numeric_limits<std::uint64_t>::max)() ? rng() : rng.below( span + 1 );
+
+        value = static_cast<T>( static_cast<std::uint64_t>( lo ) + offset );
+    }
+
+    // halve the distance to zero, or to the bound nearest to it:
+
+    template< typename F >
+    bool shrink( T const & value, F && accept ) const
+    {
+        const T target = (std::min)( (std::max)( T(), lo ), hi );
+        const bool up  = target < value;
+
+        std::uint64_t distance = up ? static_cast<std::uint64_t>( value ) - static_cast<std::uint64_t>( target )
+                                    : static_cast<std::uint64_t>( target ) - static_cast<std::uint64_t>( value );
+
+        for ( ; distance != 0; distance /= 2 )
+        {
+            if ( accept( static_cast<T>( up ? static_cast<std::uint64_t>( value ) - distance
+                                            : static_cast<std::uint64_t>( value ) + distance ) ) )
+                return true;
+        }
+        return false;
+    }
+};
+
+template< typename T >
+struct real_gen
+{
+    using value_type = T;
+
+    T lo, hi;
+
+    void generate( splitmix64 & rng, std::size_t, T & value ) const
+    {
+        value = lo + static_cast<T>( rng.unit() ) * ( hi - lo );
+    }
+
+    // try the integral part, then halve the distance to zero or the bound nearest to it:
+
+    template< typename F >
+    bool shrink( T const & value, F && accept ) const
+    {
+        const T target = (std::min)( (std::max)( T(), lo ), hi );
+        const T whole  = std::trunc( value );
+
+        if ( lo <= whole && whole <= hi && std::abs( whole - target ) < std::abs( value - target ) && accept( whole ) )
+            return true;
+
+        T distance = value - target;
+
+        for ( int i = 0; i < std::numeric_limits<T>::digits && std::abs( distance ) > T(); ++i, distance /= 2 )
+        {
+            if ( accept( value - distance ) )
+                return true;
+        }
+        return false;
+    }
+};
+
+struct bool_gen
+{
+    using value_type = bool;
+
+    void generate( splitmix64 & rng, std::size_t, bool & value ) const { value = ( rng() & 1 ) != 0; }
+
+    template< typename F >
+    bool shrink( bool const & value, F && accept ) const { return value && accept( false ); }
+};
+
+template< typename T >
+struct element_gen
+{
+    using value_type = T;
+
+    std::vector<T> items;
+
+    void generate( splitmix64 & rng, std::size_t, T & value ) const
+    {
+        value = items[ static_cast<std::size_t>( rng.below( items.size() ) ) ];
+    }
+
+    // earlier items are simpler:
+
+    template< typename F >
+    bool shrink( T const & value, F && accept ) const
+    {
+        for ( auto & item : items )
+        {
+            if ( same( item, value ) )
+                return false;
+            if ( accept( item ) )
+                return true;
+        }
+        return false;
+    }
+};
+
+// std::vector, std::basic_string, of at most size elements:
+
+template< typename G, typename C >
+struct sequence_gen
+{
+    using value_type   = C;
+    using element_type = typename G::value_type;
+
+    G element;
+    std::size_t max_size;
+
+    void generate( splitmix64 & rng, std::size_t size, C & value ) const
+    {
+        value.resize( static_cast<std::size_t>( rng.below( (std::min)( size, max_size ) + 1 ) ) );
+
+        for ( std::size_t i = 0; i < value.size(); ++i )
+        {
+            generate_element( rng, size, value, i );
+        }
+    }
+
+    // remove chunks of elements, largest first, then simplify elements:
+
+    template< typename F >
+    bool shrink( C const & value, F && accept ) const
+    {
+        for ( std::size_t k = value.size(); k > 0; k /= 2 )
+        {
+            for ( std::size_t i = 0; i + k <= value.size(); i += k )
+            {
+                C candidate; candidate.reserve( value.size() - k );
+                candidate.insert( candidate.end(), value.begin(), value.begin() + static_cast<std::ptrdiff_t>( i ) );
+                candidate.insert( candidate.end(), value.begin() + static_cast<std::ptrdiff_t>( i + k ), value.end() );
+
+                if ( accept( candidate ) )
+                    return true;
+            }
+        }
+
+        for ( std::size_t i = 0; i < value.size(); ++i )
+        {
+            auto accept_element = [&]( element_type const & x ) { C candidate( value ); candidate[i] = x; return accept( candidate ); };
+
+            if ( element.shrink( value[i], accept_element ) )
+                return true;
+        }
+        return false;
+    }
+
+private:
+    template< typename V >
+    void generate_element( splitmix64 & rng, std::size_t size, V & value, std::size_t i ) const
+    {
+        element.generate( rng, size, value[i] );
+    }
+
+    void generate_element( splitmix64 & rng, std::size_t size, std::vector<bool> & value, std::size_t i ) const
+    {
+        bool x = false; element.generate( rng, size, x ); value[i] = x;
+    }
+};
+
+template< typename G1, typename G2 >
+struct pair_gen
+{
+    using value_type = std::pair< typename G1::value_type, typename G2::value_type >;
+
+    G1 first;
+    G2 second;
+
+    void generate( splitmix64 & rng, std::size_t size, value_type & value ) const
+    {
+        first.generate ( rng, size, value.first  );
+        second.generate( rng, size, value.second );
+    }
+
+    template< typename F >
+    bool shrink( value_type const & value, F && accept ) const
+    {
+        return first.shrink ( value.first , [&]( typename G1::value_type const & x ) { return accept( value_type( x, value.second ) ); } )
+            || second.shrink( value.second, [&]( typename G2::value_type const & x ) { return accept( value_type( value.first, x ) ); } );
+    }
+};
+
+template< typename T = int >
+auto integral( T lo = (std::numeric_limits<T>::min)(), T hi = (std::numeric_limits<T>::max)() ) -> integral_gen<T>
+{
+    return integral_gen<T>{ lo, hi };
+}
+
+inline auto int_( int lo = (std::numeric_limits<int>::min)(), int hi = (std::numeric_limits<int>::max)() ) -> integral_gen<int>
+{
+    return integral_gen<int>{ lo, hi };
+}
+
+template< typename T = double >
+auto real( T lo = T( -1e6 ), T hi = T( 1e6 ) ) -> real_gen<T>
+{
+    return real_gen<T>{ lo, hi };
+}
+
+inline auto double_( double lo = -1e6, double hi = 1e6 ) -> real_gen<double>
+{
+    return real_gen<double>{ lo, hi };
+}
+
+inline auto bool_() -> bool_gen
+{
+    return bool_gen{};
+}
+
+template< typename T >
+auto element_of( std::initializer_list<T> items ) -> element_gen<T>
+{
+    return element_gen<T>{ std::vector<T>( items ) };
+}
+
+template< typename G >
+auto vector( G element, std::size_t max_size = lest_FEATURE_PROPERTY_SIZE ) -> sequence_gen< G, std::vector< typename G::value_type > >
+{
+    return sequence_gen< G, std::vector< typename G::value_type > >{ element, max_size };
+}
+
+// printable characters:
+
+inline auto string( std::size_t max_size = lest_FEATURE_PROPERTY_SIZE ) -> sequence_gen< integral_gen<char>, std::string >
+{
+    return sequence_gen< integral_gen<char>, std::string >{ integral_gen<char>{ ' ', '~' }, max_size };
+}
+
+template< typename G1, typename G2 >
+auto pair( G1 first, G2 second ) -> pair_gen<G1, G2>
+{
+    return pair_gen<G1, G2>{ first, second };
+}
+
+} // namespace gen
+
+template< typename G >
+using generated_t = typename G::value_type;
+
+#if lest_HAVE_IMPLEMENTATION
+
+struct falsified : message
+{
+    falsified( message const & e, text counterexample, text note_ )
+    : message{ "failed: property falsified", e.where, text( e.what() ) + "; counterexample: " + counterexample, note_ } {}
+};
+
+// Replace value by the simplest candidate of gen.shrink() that still fails, repeatedly,
+// trying at most lest_FEATURE_PROPERTY_SHRINKS candidates; returns the number of shrinks:
+
+template< typename G, typename P >
+int minimize( G const & gen, generated_t<G> & value, P fails )
+{
+    int shrinks  = 0;
+    int attempts = 0;
+
+    for ( bool simpler = true; simpler; )
+    {
+        generated_t<G> next;
+
+        simpler = gen.shrink( value, [&]( generated_t<G> const & candidate )
+        {
+            if ( ++attempts > lest_FEATURE_PROPERTY_SHRINKS || ! fails( candidate ) )
+                return attempts > lest_FEATURE_PROPERTY_SHRINKS;
+
+            next = candidate; return true;
+        } ) && attempts <= lest_FEATURE_PROPERTY_SHRINKS;
+
+        if ( simpler )
+        {
+            value = next; ++shrinks;
+        }
+    }
+    return shrinks;
+}
+
+// Run a property for option.cases generated values, shrink a failing value:
+
+template< typename G, typename F >
+class property_check
+{
+public:
+    using value_type = generated_t<G>;
+
+    property_check( env & output_, location where_, G const & gen_, F const & body_ )
+    : output( output_ ), quiet( output_ ), where( where_ ), gen( gen_ ), body( body_ ), depth( output_.ctx.size() )
+    {
+        quiet.opt.pass = false;
+    }
+
+    void operator()()
+    {
+        const std::uint64_t seed  = output.opt.seed;
+        const std::uint64_t cases = static_cast<std::uint64_t>( output.opt.cases );
+
+        const std::uint64_t index = output.opt.jobs > 1 ? run_parallel( seed, cases ) : run( quiet, seed, 0, 1, cases );
+
+        if ( index < cases )
+        {
+            value_type value = value_type();
+            splitmix64 rng( case_seed( seed, index ) );
+            gen.generate( rng, case_size( index ), value );
+
+            falsify( value, seed, index );
+        }
+
+        if ( output.pass() )
+            report( output, event::passed, where, "property", to_string( output.opt.cases ) + " cases, seed " + to_string( seed ) );
+    }
+
+private:
+    // index of the first failing case of first, first + step, ... before last, or last:
+
+    std::uint64_t run( env & quiet_, std::uint64_t seed, std::uint64_t first, std::uint64_t step, std::uint64_t last )
+    {
+        value_type value = value_type();
+
+        for ( std::uint64_t i = first; i < last; i += step )
+        {
+            splitmix64 rng( case_seed( seed, i ) );
+            gen.generate( rng, case_size( i ), value );
+
+            if ( ! holds( quiet_, value ) )
+                return i;
+        }
+        return last;
+    }
+
+    // Workers take the next case index from a shared counter and stop once a case
+    // with a lower index failed. As every lower index is still run, the result is the
+    // first failing case, as on a single thread. Shrinking happens on this thread.
+
+    std::uint64_t run_parallel( std::uint64_t seed, std::uint64_t cases )
+    {
+        std::atomic<std::uint64_t> next( 0 );
+        std::atomic<std::uint64_t> failed( cases );
+
+        std::mutex mutex;
+        std::exception_ptr error;
+        std::uint64_t error_index = cases;
+
+        auto worker = [&]()
+        {
+            env quiet_( quiet );
+
+            for ( std::uint64_t i = next++; i < failed.load(); i = next++ )
+            {
+                try
+                {
+                    if ( run( quiet_, seed, i, 1, i + 1 ) == i )
+                        lower( failed, i );
+                }
+                catch ( ... )
+                {
+                    std::lock_guard<std::mutex> lock( mutex );
+                    if ( i < error_index ) { error = std::current_exception(); error_index = i; }
+                    lower( failed, i );
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        const int jobs = static_cast<int>( (std::min)( static_cast<std::uint64_t>( output.opt.jobs ), cases ) );
+
+        for ( int i = 1; i < jobs; ++i )
+            workers.emplace_back( worker );
+
+        worker();
+
+        for ( auto & t : workers )
+            t.join();
+
+        if ( error && error_index <= failed.load() )
+            std::rethrow_exception( error );
+
+        return failed.load();
+    }
+
+    static void lower( std::atomic<std::uint64_t> & failed, std::uint64_t index )
+    {
+        for ( std::uint64_t current = failed.load(); index < current && ! failed.compare_exchange_weak( current, index ); ) {}
+    }
+
+    bool holds( value_type const & value )
+    {
+        return holds( quiet, value );
+    }
+
+    // any exception falsifies the property, not only a failed assertion:
+
+    bool holds( env & quiet_, value_type const & value )
+    {
+        try
+        {
+            body( quiet_, value );
+            return true;
+        }
+        catch ( ... )
+        {
+            quiet_.unwind( depth );
+            return false;
+        }
+    }
+
+    void falsify( value_type const & value, std::uint64_t seed, std::uint64_t index )
+    {
+        value_type smallest( value );
+
+        const int shrinks = minimize( gen, smallest, [&]( value_type const & candidate ) { return ! holds( candidate ); } );
+
+        const text note = "(seed " + to_string( seed ) + ", case " + to_string( index ) + ", " + to_string( shrinks ) + " " + pluralise( "shrink", shrinks ) + ")";
+
+        try
+        {
+            body( quiet, smallest );
+        }
+        catch ( message const & e )
+        {
+            throw falsified( e, to_string( smallest ), note );
+        }
+        catch ( std::exception const & e )
+        {
+            throw falsified( message{ "", where, "unexpected exception with message \"" + text( e.what() ) + "\"" }, to_string( smallest ), note );
+        }
+        catch ( ... )
+        {
+            throw falsified( message{ "", where, "unexpected exception of unknown type" }, to_string( smallest ), note );
+        }
+        throw falsified( message{ "", where, "property" }, to_string( value ) + " (not reproducible)", note );
+    }
+
+    env & output;
+    env quiet;
+    location where;
+    G const & gen;
+    F const & body;
+    std::size_t depth;
+};
+
+template< typename G >
+struct property
+{
+    G gen;
+    location where;
+
+    template< typename F >
+    auto operator*( F body ) const -> std::function<void( env & )>
+    {
+        property self( *this );
+
+        return [self, body]( env & output )
+        {
+            property_check<G, F>( output, self.where, self.gen, body )();
+        };
+    }
+};
+
+template< typename G >
+auto property_of( G const & gen, location where ) -> property<G>
+{
+    return property<G>{ gen, where };
+}
+
+// Hash of fuzz inputs and of test names in replay tokens:
+
+inline std::uint64_t fnv1a( unsigned char const * data, std::size_t size )
+{
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+
+    for ( std::size_t i = 0; i < size; ++i )
+        hash = ( hash ^ data[i] ) * 0x100000001b3ull;
+
+    return hash;
+}
+
+// A failure of code that ran on another thread, as a message:
+
+inline message message_of( std::exception_ptr error, location where, text expr, text note )
+{
+    try
+    {
+        std::rethrow_exception( error );
+    }
+    catch ( message const & e )
+    {
+        return message{ e.kind, e.where, e.what(), e.note.info.empty() ? note : e.note.info + " " + note };
+    }
+    catch ( std::exception const & e )
+    {
+        return message{ "failed: got unexpected exception with message \"" + text( e.what() ) + "\"", where, expr, note };
+    }
+    catch ( ... )
+    {
+        return message{ "failed: got unexpected exception of unknown type", where, expr, note };
+    }
+}
+
+#if lest_FEATURE_FUZZ || lest_FEATURE_DATA
+
+// Corpus inputs are memory-mapped where possible, so that a large corpus starts instantly:
+
+class mapped_file
+{
+public:
+    explicit mapped_file( text path )
+    : data_( nullptr ), size_( 0 )
+    {
+#if lest_HAVE_POSIX
+        const int fd = ::open( path.c_str(), O_RDONLY );
+        struct stat info;
+
+        if ( fd < 0 || ::fstat( fd, &info ) != 0 )
+        {
+            if ( fd >= 0 ) ::close( fd );
+            throw std::runtime_error( "cannot read file '" + path + "'" );
+        }
+
+        size_ = static_cast<std::size_t>( info.st_size );
+
+        if ( size_ > 0 )
+        {
+            void * addr = ::mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0 );
+            ::close( fd );
+
+            if ( addr == MAP_FAILED )
+                throw std::runtime_error( "cannot map file '" + path + "'" );
+
+            data_ = static_cast<unsigned char const *>( addr );
+        }
+        else
+        {
+            ::close( fd );
+        }
+#else
+        std::ifstream is( path.c_str(), std::ios::binary );
+
+        if ( ! is )
+            throw std::runtime_error( "cannot read file '" + path + "'" );
+
+        bytes.assign( std::istreambuf_iterator<char>( is ), std::istreambuf_iterator<char>() );
+        data_ = reinterpret_cast<unsigned char const *>( bytes.data() );
+        size_ = bytes.size();
+#endif
+    }
+
+    mapped_file( mapped_file && other )
+    : data_( other.data_ ), size_( other.size_ )
+#if ! lest_HAVE_POSIX
+    , bytes( std::move( other.bytes ) )
+#endif
+    {
+        other.data_ = nullptr; other.size_ = 0;
+    }
+
+    ~mapped_file()
+    {
+#if lest_HAVE_POSIX
+        if ( data_ )
+            ::munmap( const_cast<unsigned char *>( data_ ), size_ );
+#endif
+    }
+
+    unsigned char const * data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    mapped_file( mapped_file const & );
+    mapped_file & operator=( mapped_file const & );
+
+    unsigned char const * data_;
+    std::size_t size_;
+#if ! lest_HAVE_POSIX
+    std::vector<char> bytes;
+#endif
+};
+
+#endif // lest_FEATURE_FUZZ || lest_FEATURE_DATA
+
+#if lest_FEATURE_FUZZ
+
+// Fuzzing:
+
+// the file itself, or the files in a directory, in lexical order:
+
+inline std::vector<text> list_files( text path )
+{
+    std::vector<text> files;
+
+#if lest_HAVE_POSIX
+    struct stat info;
+
+    if ( ::stat( path.c_str(), &info ) != 0 )
+        throw std::runtime_error( "cannot find fuzz corpus '" + path + "'" );
+
+    if ( ! S_ISDIR( info.st_mode ) )
+        return { path };
+
+    if ( DIR * dir = ::opendir( path.c_str() ) )
+    {
+        while ( dirent * entry = ::readdir( dir ) )
+        {
+            const text file = path + "/" + entry->d_name;
+
+            if ( ::stat( file.c_str(), &info ) == 0 && S_ISREG( info.st_mode ) )
+                files.push_back( file );
+        }
+        ::closedir( dir );
+    }
+#elif lest_HAVE_FILESYSTEM
+    if ( ! std::filesystem::is_directory( path ) )
+        return { path };
+
+    for ( auto & entry : std::filesystem::directory_iterator( path ) )
+    {
+        if ( entry.is_regular_file() )
+            files.push_back( entry.path().string() );
+    }
+#else
+    files.push_back( path );
+#endif
+    std::sort( files.begin(), files.end() );
+    return files;
+}
+
+// kind-0123456789abcdef, named after the hash of the input:
+
+inline text artifact_name( text kind, unsigned char const * data, std::size_t size )
+{
+    const std::uint64_t hash = fnv1a( data, size );
+
+    text name = kind + "-";
+    for ( int shift = 60; shift >= 0; shift -= 4 )
+        name += hex_digits()[ ( hash >> shift ) & 0xf ];
+
+    return name;
+}
+
+inline text save_artifact( text dir, text kind, unsigned char const * data, std::size_t size )
+{
+    const text path = ( dir.empty() ? text( "." ) : dir ) + "/" + artifact_name( kind, data, size );
+
+    std::ofstream os( path.c_str(), std::ios::binary );
+    os.write( reinterpret_cast<char const *>( data ), static_cast<std::streamsize>( size ) );
+
+    if ( ! os )
+        throw std::runtime_error( "cannot save fuzz input to '" + path + "'" );
+
+    return path;
+}
+
+#if lest_HAVE_POSIX
+
+// Save the input that is running when the process crashes, as crash-{hash};
+// the signal handler only uses async-signal-safe functions:
+
+struct crash_input
+{
+    unsigned char const * volatile data;
+    volatile std::size_t size;
+    char path[ 1024 ];
+    std::size_t length;
+};
+
+inline crash_input & current_input()
+{
+    static crash_input input = { nullptr, 0, { 0 }, 0 };
+    return input;
+}
+
+inline void on_crash( int signal_number )
+{
+    crash_input & input = current_input();
+
+    const std::uint64_t hash = fnv1a( input.data, input.size );
+
+    char * end = input.path + input.length;
+    for ( char const * s = "crash-"; *s; ) *end++ = *s++;
+    for ( int shift = 60; shift >= 0; shift -= 4 ) *end++ = hex_digits()[ ( hash >> shift ) & 0xf ];
+    *end = '\0';
+
+    const int fd = ::open( input.path, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if ( fd >= 0 )
+    {
+        if ( ::write( fd, input.data, input.size ) ) {}
+        ::close( fd );
+    }
+
+    char const * note = "lest: fuzz input crashed, saved as ";
+    if ( ::write( 2, note, std::strlen( note ) ) ) {}
+    if ( ::write( 2, input.path, std::strlen( input.path ) ) ) {}
+    if ( ::write( 2, "\n", 1 ) ) {}
+
+    ::raise( signal_number );
+}
+
+class crash_guard
+{
+public:
+    explicit crash_guard( text dir )
+    {
+        crash_input & input = current_input();
+        const text prefix = ( dir.empty() ? text( "." ) : dir ) + "/";
+
+        input.length = (std::min)( prefix.size(), sizeof input.path - 32 );
+        std::memcpy( input.path, prefix.data(), input.length );
+
+        struct sigaction action;
+        std::memset( &action, 0, sizeof action );
+        action.sa_handler = on_crash;
+        action.sa_flags   = static_cast<int>( SA_RESETHAND );
+        sigemptyset( &action.sa_mask );
+
+        for ( std::size_t i = 0; i < count; ++i )
+            ::sigaction( signals()[i], &action, &previous[i] );
+    }
+
+    ~crash_guard()
+    {
+        for ( std::size_t i = 0; i < count; ++i )
+            ::sigaction( signals()[i], &previous[i], nullptr );
+
+        current_input().data = nullptr;
+        current_input().size = 0;
+    }
+
+    static void running( unsigned char const * data, std::size_t size )
+    {
+        current_input().data = data;
+        current_input().size = size;
+    }
+
+private:
+    static const std::size_t count = 5;
+    static int const * signals() { static const int list[ count ] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT }; return list; }
+
+    struct sigaction previous[ count ];
+};
+
+#else
+
+class crash_guard
+{
+public:
+    explicit crash_guard( text ) {}
+    static void running( unsigned char const *, std::size_t ) {}
+};
+
+#endif
+
+// Byte-level mutations, stacked a few at a time:
+
+class mutator
+{
+public:
+    using bytes = std::vector<unsigned char>;
+
+    mutator( splitmix64 & rng_, std::size_t max_size_ )
+    : rng( rng_ ), max_size( max_size_ ) {}
+
+    void operator()( bytes & input, std::vector<mapped_file> const & corpus )
+    {
+        for ( std::uint64_t n = 1 + rng.below( 4 ); n > 0; --n )
+            mutate( input, corpus );
+    }
+
+private:
+    void mutate( bytes & input, std::vector<mapped_file> const & corpus )
+    {
+        const std::size_t size = input.size();
+        const std::size_t room = max_size - size;
+
+        switch ( rng.below( 10 ) )
+        {
+        case 0: // erase bytes
+            if ( size > 0 )
+            {
+                const std::size_t pos = below( size ), n = 1 + below( (std::min)( size - pos, std::size_t( 8 ) ) );
+                input.erase( input.begin() + offset( pos ), input.begin() + offset( pos + n ) );
+                return;
+            }
+            break;
+
+        case 1: // insert a byte
+            if ( room > 0 )
+            {
+                input.insert( input.begin() + offset( below( size + 1 ) ), byte() );
+                return;
+            }
+            break;
+
+        case 2: // insert repeated bytes
+            if ( room > 0 )
+            {
+                input.insert( input.begin() + offset( below( size + 1 ) ), 1 + below( (std::min)( room, std::size_t( 16 ) ) ), byte() );
+                return;
+            }
+            break;
+
+        case 3: // change a byte
+            if ( size > 0 ) { input[ below( size ) ] = byte(); return; }
+            break;
+
+        case 4: // flip a bit
+            if ( size > 0 ) { input[ below( size ) ] ^= static_cast<unsigned char>( 1u << below( 8 ) ); return; }
+            break;
+
+        case 5: // add to or subtract from a byte
+            if ( size > 0 ) { input[ below( size ) ] += static_cast<unsigned char>( rng.below( 71 ) + 256 - 35 ); return; }
+            break;
+
+        case 6: // shuffle a few bytes
+            if ( size > 1 )
+            {
+                const std::size_t pos = below( size ), n = (std::min)( size - pos, std::size_t( 8 ) );
+                for ( std::size_t i = n; i > 1; --i )
+                    std::swap( input[ pos + i - 1 ], input[ pos + below( i ) ] );
+                return;
+            }
+            break;
+
+        case 7: // overwrite with an interesting value of 1, 2, 4 or 8 bytes
+        {
+            const std::size_t width = std::size_t( 1 ) << below( 4 );
+            if ( size >= width )
+            {
+                static const std::uint64_t values[] = { 0, 1, 0x7f, 0x80, 0xff, 0x7fff, 0x8000, 0xffff, 0x7fffffff, 0x80000000, 0xffffffff, ~0ull };
+                const std::uint64_t value = values[ below( sizeof values / sizeof values[0] ) ];
+                const std::size_t pos = below( size - width + 1 );
+                for ( std::size_t i = 0; i < width; ++i )
+                    input[ pos + i ] = static_cast<unsigned char>( value >> ( 8 * i ) );
+                return;
+            }
+            break;
+        }
+
+        case 8: // copy a part of the input elsewhere
+            if ( size > 1 )
+            {
+                const std::size_t from = below( size ), to = below( size ), n = 1 + below( size - (std::max)( from, to ) );
+                std::memmove( &input[ to ], &input[ from ], n );
+                return;
+            }
+            break;
+
+        case 9: // splice in a part of a corpus input
+            if ( ! corpus.empty() && room > 0 )
+            {
+                mapped_file const & other = corpus[ below( corpus.size() ) ];
+                if ( other.size() > 0 )
+                {
+                    const std::size_t from = below( other.size() ), n = 1 + below( (std::min)( other.size() - from, room ) );
+                    input.insert( input.begin() + offset( below( size + 1 ) ), other.data() + from, other.data() + from + n );
+                    return;
+                }
+            }
+            break;
+        }
+
+        // the chosen mutation did not apply:
+
+        if ( room > 0 ) input.push_back( byte() );
+        else if ( size > 0 ) input.pop_back();
+    }
+
+    std::size_t below( std::size_t n ) { return static_cast<std::size_t>( rng.below( n ) ); }
+    unsigned char byte() { return static_cast<unsigned char>( rng() ); }
+    static std::ptrdiff_t offset( std::size_t pos ) { return static_cast<std::ptrdiff_t>( pos ); }
+
+    splitmix64 & rng;
+    std::size_t max_size;
+};
+
+struct fuzz_failure : message
+{
+    fuzz_failure( message const & e, text note_ )
+    : message{ "failed: fuzz input", e.where, e.what(), note_ } {}
+};
+
+// Run a fuzz case on its corpus, or for option.fuzz seconds on mutated inputs:
+
+template< typename F >
+class fuzz_check
+{
+public:
+    using bytes = std::vector<unsigned char>;
+
+    fuzz_check( env & output_, location where_, F const & body_ )
+    : output( output_ ), quiet( output_ ), where( where_ ), body( body_ ), depth( output_.ctx.size() )
+    {
+        quiet.opt.pass = false;
+    }
+
+    void operator()()
+    {
+        std::vector<text> files;
+        std::vector<mapped_file> corpus;
+
+        if ( ! output.opt.corpus.empty() )
+        {
+            files = list_files( output.opt.corpus );
+
+            for ( auto & file : files )
+                corpus.emplace_back( file );
+        }
+
+        if ( output.opt.fuzz > 0 )
+            return fuzz( corpus );
+
+        // regression: run the corpus inputs, or the empty input:
+
+        for ( std::size_t i = 0; i < corpus.size(); ++i )
+        {
+            if ( ! holds( corpus[i].data(), corpus[i].size() ) )
+                fail( bytes( corpus[i].data(), corpus[i].data() + corpus[i].size() ), "(" + to_string( corpus[i].size() ) + " " + pluralise( "byte", static_cast<int>( corpus[i].size() ) ) + ", " + files[i] + ")" );
+        }
+
+        if ( corpus.empty() && ! holds( nullptr, 0 ) )
+            fail( bytes(), "(0 bytes)" );
+
+        if ( output.pass() )
+            report( output, event::passed, where, "fuzz", corpus.empty() ? "empty input" : "corpus of " + to_string( corpus.size() ) + " " + pluralise( "input", static_cast<int>( corpus.size() ) ) );
+    }
+
+private:
+    void fuzz( std::vector<mapped_file> const & corpus )
+    {
+        using clock = std::chrono::steady_clock;
+
+        const auto start = clock::now();
+        const auto stop  = start + std::chrono::seconds( output.opt.fuzz );
+
+        splitmix64 rng( output.opt.seed );
+        mutator mutate( rng, lest_FEATURE_FUZZ_MAX_SIZE );
+
+        bytes input;
+        input.reserve( lest_FEATURE_FUZZ_MAX_SIZE );
+
+        crash_guard guard( output.opt.artifacts );
+
+        std::uint64_t runs = 0;
+
+        for ( ; ( runs & 0xff ) != 0 || clock::now() < stop; ++runs )
+        {
+            // start afresh from a corpus input or the empty input now and then:
+
+            if ( ( runs & 0xf ) == 0 )
+            {
+                const std::size_t pick = static_cast<std::size_t>( rng.below( corpus.size() + 1 ) );
+
+                if ( pick < corpus.size() )
+                    input.assign( corpus[pick].data(), corpus[pick].data() + (std::min)( corpus[pick].size(), std::size_t( lest_FEATURE_FUZZ_MAX_SIZE ) ) );
+                else
+                    input.clear();
+            }
+
+            mutate( input, corpus );
+
+            crash_guard::running( input.data(), input.size() );
+
+            if ( ! holds( input.data(), input.size() ) )
+            {
+                bytes failing( input );
+                text note;
+
+                if ( output.opt.minimize )
+                {
+                    const int shrinks = minimize( gen::vector( gen::integral<unsigned char>(), failing.size() ), failing,
+                        [&]( bytes const & candidate ) { return ! holds( candidate.data(), candidate.size() ); } );
+
+                    note = ", minimized in " + to_string( shrinks ) + " " + pluralise( "step", shrinks );
+                }
+
+                const text path = save_artifact( output.opt.artifacts, "failure", failing.data(), failing.size() );
+
+                fail( failing, "(" + to_string( failing.size() ) + " " + pluralise( "byte", static_cast<int>( failing.size() ) )
+                    + ", run " + to_string( runs ) + ", seed " + to_string( output.opt.seed ) + note + ", saved as " + path + ")" );
+            }
+        }
+
+        if ( output.pass() )
+        {
+            const double seconds = std::chrono::duration<double>( clock::now() - start ).count();
+
+            report( output, event::passed, where, "fuzz", to_string( runs ) + " runs in " + to_string( static_cast<int>( seconds + 0.5 ) ) + " s ("
+                + to_string( static_cast<std::uint64_t>( static_cast<double>( runs ) / seconds ) ) + " runs/s), seed " + to_string( output.opt.seed )
+                + ", corpus of " + to_string( corpus.size() ) + " " + pluralise( "input", static_cast<int>( corpus.size() ) ) );
+        }
+    }
+
+    bool holds( unsigned char const * data, std::size_t size )
+    {
+        static const unsigned char none = 0;
+
+        try
+        {
+            body( quiet, data ? data : &none, size );
+            return true;
+        }
+        catch ( ... )
+        {
+            quiet.unwind( depth );
+            return false;
+        }
+    }
+
+    // rerun the failing input for its report:
+
+    void fail( bytes const & input, text note )
+    {
+        static const unsigned char none = 0;
+
+        try
+        {
+            body( quiet, input.empty() ? &none : input.data(), input.size() );
+        }
+        catch ( message const & e )
+        {
+            throw fuzz_failure( e, note );
+        }
+        catch ( std::exception const & e )
+        {
+            throw fuzz_failure( message{ "", where, "unexpected exception with message \"" + text( e.what() ) + "\"" }, note );
+        }
+        catch ( ... )
+        {
+            throw fuzz_failure( message{ "", where, "unexpected exception of unknown type" }, note );
+        }
+        throw fuzz_failure( message{ "", where, "fuzz case (not reproducible)" }, note );
+    }
+
+    env & output;
+    env quiet;
+    location where;
+    F const & body;
+    std::size_t depth;
+};
+
+struct fuzz_case
+{
+    location where;
+
+    template< typename F >
+    auto operator*( F body ) const -> std::function<void( env & )>
+    {
+        const location at( where );
+
+        return [at, body]( env & output )
+        {
+            fuzz_check<F>( output, at, body )();
+        };
+    }
+};
+
+inline auto fuzz_of( location where ) -> fuzz_case
+{
+    return fuzz_case{ where };
+}
+
+#endif // lest_FEATURE_FUZZ
+
+#if lest_FEATURE_DATA
+
+// Data-driven cases:
+
+// Zero-copy view of a field of a data table row; quoted fields exclude the quotes:
+
+class field
+{
+public:
+    field( char const * first, std::size_t size, bool escaped )
+    : first_( first ), size_( size ), escaped_( escaped ) {}
+
+    char const * data() const { return first_; }
+    std::size_t  size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // copy, with doubled quotes of a quoted field undone:
+
+    text str() const
+    {
+        if ( ! escaped_ )
+            return text( first_, size_ );
+
+        text result;
+        for ( std::size_t i = 0; i < size_; ++i )
+        {
+            result += first_[i];
+            if ( first_[i] == '"' ) ++i;
+        }
+        return result;
+    }
+
+    template< typename T >
+    T as() const
+    {
+        static_assert( std::is_arithmetic<T>::value, "field::as<T>() requires an integral or floating point type" );
+
+        char buf[ 64 ];
+
+        if ( size_ == 0 || size_ >= sizeof buf )
+            throw std::invalid_argument( "cannot convert field \"" + str() + "\" to a number" );
+
+        std::memcpy( buf, first_, size_ ); buf[ size_ ] = '\0';
+
+        char * end = nullptr; errno = 0;
+        const T value = convert( buf, &end, static_cast<T *>( nullptr ) );
+
+        if ( end != buf + size_ || errno == ERANGE )
+            throw std::invalid_argument( "cannot convert field \"" + str() + "\" to a number" );
+
+        return value;
+    }
+
+    bool equals( char const * txt, std::size_t n ) const
+    {
+        return escaped_ ? str() == text( txt, n ) : size_ == n && std::memcmp( first_, txt, n ) == 0;
+    }
+
+private:
+    template< typename T >
+    static auto convert( char const * buf, char ** end, T * ) -> typename std::enable_if< std::is_floating_point<T>::value, T >::type
+    {
+        return static_cast<T>( std::strtold( buf, end ) );
+    }
+
+    template< typename T >
+    static auto convert( char const * buf, char ** end, T * ) -> typename std::enable_if< std::is_integral<T>::value && std::is_signed<T>::value, T >::type
+    {
+        const long long value = std::strtoll( buf, end, 10 );
+        if ( value < (std::numeric_limits<T>::min)() || value > (std::numeric_limits<T>::max)() ) errno = ERANGE;
+        return static_cast<T>( value );
+    }
+
+    template< typename T >
+    static auto convert( char const * buf, char ** end, T * ) -> typename std::enable_if< std::is_integral<T>::value && ! std::is_signed<T>::value, T >::type
+    {
+        const unsigned long long value = std::strtoull( buf, end, 10 );
+        if ( buf[0] == '-' || value > (std::numeric_limits<T>::max)() ) errno = ERANGE;
+        return static_cast<T>( value );
+    }
+
+    char const * first_;
+    std::size_t size_;
+    bool escaped_;
+};
+
+inline bool operator==( field const & a, text const & b ) { return a.equals( b.data(), b.size() ); }
+inline bool operator==( text const & a, field const & b ) { return b == a; }
+inline bool operator!=( field const & a, text const & b ) { return !( a == b ); }
+inline bool operator!=( text const & a, field const & b ) { return !( b == a ); }
+
+inline bool operator==( field const & a, char const * b ) { return a.equals( b, std::strlen( b ) ); }
+inline bool operator==( char const * a, field const & b ) { return b == a; }
+inline bool operator!=( field const & a, char const * b ) { return !( a == b ); }
+inline bool operator!=( char const * a, field const & b ) { return !( b == a ); }
+
+inline void format_to( appender & out, field const & value )
+{
+    const text txt = value.str();
+    append_quoted( out, '"', txt.data(), txt.size() );
+}
+
+// A row of a delimited text table; its fields refer to the mapped file:
+
+class data_row
+{
+public:
+    std::size_t line() const { return line_; }
+    std::size_t size() const { return fields.size(); }
+
+    field const & operator[]( std::size_t i ) const { return fields[i]; }
+
+    field const & at( std::size_t i ) const
+    {
+        if ( i >= fields.size() )
+            throw std::out_of_range( "row at line " + to_string( line_ ) + " has " + to_string( fields.size() ) + " fields, no field " + to_string( i ) );
+
+        return fields[i];
+    }
+
+    text str() const { return text( first, last ); }
+
+private:
+    friend class csv_table;
+
+    std::size_t line_ = 0;
+    char const * first = nullptr;
+    char const * last  = nullptr;
+    std::vector<field> fields;
+};
+
+// Rows of a CSV (or TSV) file: lines, except empty lines and lines that start with '#';
+// rows are indexed up front, their fields are split when the row is used:
+
+class csv_table
+{
+public:
+    using row_type = data_row;
+
+    csv_table( unsigned char const * data, std::size_t size, char delimiter_ )
+    : delimiter( delimiter_ )
+    {
+        char const * pos = reinterpret_cast<char const *>( data );
+        char const * end = pos + size;
+
+        for ( std::size_t line = 1; pos < end; ++line )
+        {
+            char const * eol = static_cast<char const *>( std::memchr( pos, '\n', static_cast<std::size_t>( end - pos ) ) );
+            char const * next = eol ? eol + 1 : end;
+
+            if ( ! eol ) eol = end;
+            if ( eol > pos && eol[-1] == '\r' ) --eol;
+
+            if ( eol > pos && *pos != '#' )
+                rows.push_back( span{ pos, eol, line } );
+
+            pos = next;
+        }
+    }
+
+    std::size_t size() const { return rows.size(); }
+
+    void fill( std::size_t i, data_row & row ) const
+    {
+        span const & r = rows[i];
+
+        row.line_ = r.line;
+        row.first = r.first;
+        row.last  = r.last;
+        row.fields.clear();
+
+        for ( char const * pos = r.first; ; ++pos )
+        {
+            if ( pos < r.last && *pos == '"' )
+            {
+                char const * begin = ++pos;
+                bool escaped = false;
+
+                for ( ; pos < r.last; ++pos )
+                {
+                    if ( *pos != '"' )
+                        continue;
+
+                    if ( pos + 1 == r.last || pos[1] != '"' )
+                        break;
+
+                    escaped = true; ++pos;
+                }
+
+                row.fields.emplace_back( begin, static_cast<std::size_t>( pos - begin ), escaped );
+
+                pos = std::find( pos, r.last, delimiter );
+            }
+            else
+            {
+                char const * stop = std::find( pos, r.last, delimiter );
+                row.fields.emplace_back( pos, static_cast<std::size_t>( stop - pos ), false );
+                pos = stop;
+            }
+
+            if ( pos >= r.last )
+                break;
+        }
+    }
+
+    text describe( std::size_t i ) const
+    {
+        span const & r = rows[i];
+        const std::size_t width = 60;
+        const std::size_t size  = static_cast<std::size_t>( r.last - r.first );
+
+        return "line " + to_string( r.line ) + ": " + ( size > width ? text( r.first, width ) + "..." : text( r.first, size ) );
+    }
+
+private:
+    struct span { char const * first; char const * last; std::size_t line; };
+
+    char delimiter;
+    std::vector<span> rows;
+};
+
+// Fixed-size binary records of a trivially copyable type:
+
+template< typename T >
+class record_table
+{
+public:
+    using row_type = T;
+
+    record_table( unsigned char const * data_, std::size_t size_, char )
+    : data( data_ ), count( size_ / sizeof( T ) )
+    {
+        if ( size_ % sizeof( T ) != 0 )
+            throw std::runtime_error( "data table size " + to_string( size_ ) + " is not a multiple of the record size " + to_string( sizeof( T ) ) );
+    }
+
+    std::size_t size() const { return count; }
+
+    void fill( std::size_t i, T & record ) const
+    {
+        std::memcpy( &record, data + i * sizeof( T ), sizeof( T ) );
+    }
+
+    text describe( std::size_t i ) const
+    {
+        return "record " + to_string( i );
+    }
+
+private:
+    unsigned char const * data;
+    std::size_t count;
+};
+
+// Run the body for each row of a memory-mapped table, on option.jobs threads,
+// and report each failing (or with --pass, passing) row in table order:
+
+template< typename Table, typename F >
+class data_check
+{
+public:
+    using row_type = typename Table::row_type;
+
+    data_check( env & output_, location where_, text path_, F const & body_ )
+    : output( output_ ), quiet( output_ ), where( where_ ), path( path_ ), body( body_ ), depth( output_.ctx.size() )
+    {
+        quiet.opt.pass = false;
+    }
+
+    void operator()()
+    {
+        const mapped_file file( path );
+        const Table table( file.data(), file.size(), ends_with( path, ".tsv" ) ? '\t' : ',' );
+
+        const std::size_t rows = table.size();
+        std::vector<std::exception_ptr> outcome( rows );
+        std::atomic<std::size_t> next( 0 );
+
+        auto worker = [&]()
+        {
+            env quiet_( quiet );
+            row_type row = row_type();
+
+            for ( std::size_t i = next++; i < rows; i = next++ )
+            {
+                try
+                {
+                    table.fill( i, row );
+                    body( quiet_, row );
+                }
+                catch ( ... )
+                {
+                    quiet_.unwind( depth );
+                    outcome[i] = std::current_exception();
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        const std::size_t jobs = (std::min)( static_cast<std::size_t>( output.opt.jobs ), rows );
+
+        for ( std::size_t i = 1; i < jobs; ++i )
+            workers.emplace_back( worker );
+
+        worker();
+
+        for ( auto & t : workers )
+            t.join();
+
+        int failures = 0;
+
+        for ( std::size_t i = 0; i < rows; ++i )
+        {
+            if ( outcome[i] )
+            {
+                ++failures;
+                report( output, message_of( outcome[i], where, "row", "(" + table.describe( i ) + ")" ) );
+            }
+            else if ( output.pass() )
+            {
+                report( output, event::passed, where, "row", table.describe( i ) );
+            }
+        }
+
+        if ( failures > 0 )
+            throw message{ "failed: data table", where, path, "(" + to_string( failures ) + " out of " + to_string( rows ) + " " + pluralise( "row", static_cast<int>( rows ) ) + " failed)" };
+    }
+
+private:
+    static bool ends_with( text const & s, text const & suffix )
+    {
+        return s.size() >= suffix.size() && s.compare( s.size() - suffix.size(), suffix.size(), suffix ) == 0;
+    }
+
+    env & output;
+    env quiet;
+    location where;
+    text path;
+    F const & body;
+    std::size_t depth;
+};
+
+template< typename Table >
+struct data_case
+{
+    text path;
+    location where;
+
+    template< typename F >
+    auto operator*( F body ) const -> std::function<void( env & )>
+    {
+        data_case self( *this );
+
+        return [self, body]( env & output )
+        {
+            data_check<Table, F>( output, self.where, self.path, body )();
+        };
+    }
+};
+
+inline auto data_of( text path, location where ) -> data_case<csv_table>
+{
+    return data_case<csv_table>{ path, where };
+}
+
+template< typename T >
+auto records_of( text path, location where ) -> data_case< record_table<T> >
+{
+    return data_case< record_table<T> >{ path, where };
+}
+
+#endif // lest_FEATURE_DATA
+
+struct action
+{
+    std::ostream & os;
+
+    action( std::ostream & out ) : os( out ) {}
+
+    action( action const & ) = delete;
+    void operator=( action const & ) = delete;
+
+    operator      int() { return 0; }
+    bool        abort() { return false; }
+    action & operator()( test ) { return *this; }
+};
+
+struct print : action
+{
+    print( std::ostream & out ) : action( out ) {}
+
+    print & operator()( test testing )
+    {
+        os << testing.name << "\n"; return *this;
+    }
+};
+
+// List the section tree of a test: each level is discovered by a run that
+// follows the path to it and collects the sections there without entering them:
+
+struct psections : action
+{
+    env output;
+
+    psections( std::ostream & out, options option )
+    : action( out ), output( out, option )
+    {
+        output.opt.pass = false;
+    }
+
+    psections & operator()( test testing )
+    {
+        os << testing.name << "\n";
+        list( testing, texts(), 1 );
+        return *this;
+    }
+
+private:
+    void list( test const & testing, texts path, int level )
+    {
+        for ( auto & name : discover( testing, path ) )
+        {
+            os << text( static_cast<std::size_t>( 2 * level ), ' ' ) << name << "\n";
+
+            path.push_back( name );
+            list( testing, path, level + 1 );
+            path.pop_back();
+        }
+    }
+
+    texts discover( test const & testing, texts const & path )
+    {
+        texts found;
+
+        output.opt.section = path;
+        output.listing = &found;
+
+        try
+        {
+            perform( testing, output( testing.name ) );
+        }
+        catch ( ... ) {}
+
+        output.listing = nullptr;
+        return found;
+    }
+};
+
+inline texts tags( text name, texts result = {} )
+{
+    auto none = std::string::npos;
+    auto lb   = name.find_first_of( "[" );
+    auto rb   = name.find_first_of( "]" );
+
+    if ( lb == none || rb == none )
+        return result;
+
+    result.emplace_back( name.substr( lb, rb - lb + 1 ) );
+
+    return tags( name.substr( rb + 1 ), result );
+}
+
+struct ptags : action
+{
+    std::set<text> result;
+
+    ptags( std::ostream & out ) : action( out ), result() {}
+
+    ptags & operator()( test testing )
+    {
+        for ( auto & tag : tags( testing.name ) )
+            result.insert( tag );
+
+        return *this;
+    }
+
+    ~ptags()
+    {
+        std::copy( result.begin(), result.end(), std::ostream_iterator<text>( os, "\n" ) );
+    }
+};
+
+struct count : action
+{
+    int n = 0;
+
+    count( std::ostream & out ) : action( out ) {}
+
+    count & operator()( test ) { ++n; return *this; }
+
+    ~count()
+    {
+        os << n << " selected " << pluralise("test", n) << "\n";
+    }
+};
+
+struct timer
+{
+    using time = std::chrono::high_resolution_clock;
+
+    time::time_point start = time::now();
+
+    double elapsed_seconds() const
+    {
+        return 1e-6 * static_cast<double>( std::chrono::duration_cast< std::chrono::microseconds >( time::now() - start ).count() );
+    }
+};
+
+// Suite fixtures: named state that is made on first use by a test, shared
+// read-only by the tests of a run and their threads, and torn down after the
+// last selected test that carries the fixture's name as tag, "[name]", or at
+// the end of the run:
+
+class fixture_base;
+
+class fixture_registry
+{
+public:
+    struct record
+    {
+        text name;
+        text what;
+        double seconds;
+    };
+
+    void add( fixture_base * f ) { std::lock_guard<std::mutex> lock( mutex ); all.push_back( f ); }
+    void remove( fixture_base * f ) { std::lock_guard<std::mutex> lock( mutex ); all.erase( std::remove( all.begin(), all.end(), f ), all.end() ); }
+
+    void log( text name, text what, double seconds )
+    {
+        std::lock_guard<std::mutex> lock( mutex ); records.push_back( record{ name, what, seconds } );
+    }
+
+    std::size_t logged() { std::lock_guard<std::mutex> lock( mutex ); return records.size(); }
+
+    std::vector<record> since( std::size_t n )
+    {
+        std::lock_guard<std::mutex> lock( mutex ); return std::vector<record>( records.begin() + static_cast<std::ptrdiff_t>( n ), records.end() );
+    }
+
+    // each run, also a nested one, counts the selected users of each fixture:
+
+    void start( tests const & specification, texts const & in, int repeat );
+    void finished( text const & name );
+    void stop();
+
+private:
+    struct use
+    {
+        fixture_base * f;
+        int users;      // remaining selected users, -1: until the end of the run
+        bool built;     // already made when the run started
+    };
+
+    std::mutex mutex;
+    std::vector<fixture_base *> all;
+    std::vector< std::vector<use> > runs;
+    std::vector<record> records;
+};
+
+inline fixture_registry & fixtures()
+{
+    static fixture_registry registry;
+    return registry;
+}
+
+inline std::size_t fixture_events()
+{
+    return fixtures().logged();
+}
+
+class fixture_base
+{
+public:
+    explicit fixture_base( text name_ ) : name( name_ ), ready( false ) { fixtures().add( this ); }
+    virtual ~fixture_base() { fixtures().remove( this ); }
+
+    fixture_base( fixture_base const & ) = delete;
+    void operator=( fixture_base const & ) = delete;
+
+    bool built() const { return ready; }
+    bool used_by( text const & test_name ) const { return test_name.find( "[" + name + "]" ) != text::npos; }
+
+    virtual void teardown() = 0;
+
+    text const name;
+
+protected:
+    std::atomic<bool> ready;
+};
+
+template< typename T >
+class fixture : public fixture_base
+{
+public:
+    template< typename F >
+    fixture( text name_, F make_ )
+    : fixture_base( name_ ), make( make_ ) {}
+
+    ~fixture() { teardown(); }
+
+    T const & operator()()
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+
+        if ( ! value )
+        {
+            timer t;
+            value.reset( new T( make() ) );
+            ready = true;
+            fixtures().log( name, "setup", t.elapsed_seconds() );
+        }
+        return *value;
+    }
+
+    void teardown()
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+
+        if ( value )
+        {
+            timer t;
+            value.reset();
+            ready = false;
+            fixtures().log( name, "teardown", t.elapsed_seconds() );
+        }
+    }
+
+private:
+    std::function<T()> make;
+    std::unique_ptr<T> value;
+    std::mutex mutex;
+};
+
+inline void fixture_registry::start( tests const & specification, texts const & in, int repeat )
+{
+    std::lock_guard<std::mutex> lock( mutex );
+
+    std::vector<use> frame;
+
+    for ( auto f : all )
+    {
+        int users = 0;
+
+        for ( auto & testing : specification )
+        {
+            if ( select( testing.name, in ) && f->used_by( testing.name ) )
+                ++users;
+        }
+        frame.push_back( use{ f, users == 0 || indefinite( repeat ) ? -1 : users * repeat, f->built() } );
+    }
+    runs.push_back( frame );
+}
+
+inline void fixture_registry::finished( text const & name )
+{
+    std::vector<fixture_base *> last;
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+
+        if ( runs.empty() )
+            return;
+
+        for ( auto & u : runs.back() )
+        {
+            if ( u.users > 0 && u.f->used_by( name ) && --u.users == 0 )
+                last.push_back( u.f );
+        }
+    }
+    for ( auto f : last )
+        f->teardown();
+}
+
+inline void fixture_registry::stop()
+{
+    std::vector<fixture_base *> last;
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+
+        if ( runs.empty() )
+            return;
+
+        // leave the fixtures of an enclosing run as they were:
+
+        for ( auto & u : runs.back() )
+        {
+            if ( ! u.built && std::find( all.begin(), all.end(), u.f ) != all.end() )
+                last.push_back( u.f );
+        }
+        runs.pop_back();
+    }
+    for ( auto f : last )
+        f->teardown();
+}
+
+// Stress tests: run the code on each of the threads for the given number of
+// iterations, the threads released together from a spin barrier. Report each
+// thread's first failure, and with --pass or --time the throughput and the
+// imbalance: how much longer the slowest thread took than the mean:
+
+inline void pin_thread( int index )
+{
+#if lest_HAVE_PROCFS
+    const unsigned processors = (std::max)( 1u, std::thread::hardware_concurrency() );
+
+    cpu_set_t cpus;
+    CPU_ZERO( &cpus );
+    CPU_SET( static_cast<unsigned>( index ) % processors, &cpus );
+    pthread_setaffinity_np( pthread_self(), sizeof cpus, &cpus );
+#else
+    (void) index;
+#endif
+}
+
+class stress
+{
+public:
+    stress( env & output_, location where_, text expr_, int threads_, int iterations_ )
+    : output( output_ ), where( where_ ), expr( expr_ ), threads( threads_ ), iterations( iterations_ ) {}
+
+    template< typename F >
+    void operator*( F const & body ) const
+    {
+        if ( threads < 1 || iterations < 0 )
+            throw message{ "failed: stress", where, expr, "(requires at least 1 thread and 0 iterations)" };
+
+        std::vector<outcome> outcomes( static_cast<std::size_t>( threads ) );
+        std::atomic<int> arrived( 0 );
+        std::atomic<bool> go( false );
+        std::atomic<bool> cancelled( false );
+
+        // a failing assertion ends the thread:
+
+        auto worker = [&]( int t )
+        {
+            if ( output.opt.pin )
+                pin_thread( t );
+
+            env::adopted() = true;
+            outcome & out = outcomes[ static_cast<std::size_t>( t ) ];
+
+            ++arrived;
+            while ( ! go.load( std::memory_order_acquire ) )
+                std::this_thread::yield();
+
+            if ( cancelled.load() )
+                return;
+
+            timer clock;
+
+            for ( int i = 0; i < iterations; ++i, ++out.done )
+            {
+                try
+                {
+                    body( t, i );
+                }
+                catch ( ... )
+                {
+                    out.error = std::current_exception(); out.iteration = i;
+                    break;
+                }
+            }
+            out.seconds = clock.elapsed_seconds();
+        };
+
+        std::vector<std::thread> workers;
+
+        // if a thread cannot be started, let the started ones go without work:
+
+        try
+        {
+            for ( int t = 0; t < threads; ++t )
+                workers.emplace_back( worker, t );
+        }
+        catch ( ... )
+        {
+            cancelled.store( true );
+            go.store( true, std::memory_order_release );
+
+            for ( auto & w : workers )
+                w.join();
+            throw;
+        }
+
+        while ( arrived.load() < threads )
+            std::this_thread::yield();
+
+        timer wall;
+        go.store( true, std::memory_order_release );
+
+        for ( auto & w : workers )
+            w.join();
+
+        const double seconds = wall.elapsed_seconds();
+
+        if ( output.pass() || output.opt.time )
+            report( output, event( summary( outcomes, seconds ) ) );
+
+        int failures = 0;
+
+        for ( std::size_t t = 0; t < outcomes.size(); ++t )
+        {
+            if ( outcomes[t].error )
+            {
+                ++failures;
+                report( output, message_of( outcomes[t].error, where, expr, "(thread " + to_string( t ) + ", iteration " + to_string( outcomes[t].iteration ) + ")" ) );
+            }
+        }
+
+        if ( failures > 0 )
+            throw message{ "failed: stress", where, expr, "(" + to_string( failures ) + " out of " + to_string( threads ) + " " + pluralise( "thread", threads ) + " failed)" };
+    }
+
+private:
+    struct outcome
+    {
+        double seconds;
+        long long done;
+        int iteration;
+        std::exception_ptr error;
+
+        outcome() : seconds( 0 ), done( 0 ), iteration( 0 ), error() {}
+    };
+
+    // file:line: stress: test: expr: 4000 ops in 1.2 ms, 3333333 ops/s, imbalance 8% (fastest thread 2, slowest thread 0)
+    //   thread 0: 1000 ops in 1.2 ms
+    //   ...
+
+    text summary( std::vector<outcome> const & outcomes, double seconds ) const
+    {
+        long long ops = 0;
+        double total = 0;
+        std::size_t fastest = 0, slowest = 0;
+
+        for ( std::size_t t = 0; t < outcomes.size(); ++t )
+        {
+            ops += outcomes[t].done; total += outcomes[t].seconds;
+
+            if ( outcomes[t].seconds < outcomes[fastest].seconds ) fastest = t;
+            if ( outcomes[t].seconds > outcomes[slowest].seconds ) slowest = t;
+        }
+
+        const double mean = outcomes.empty() ? 0 : total / static_cast<double>( outcomes.size() );
+        const double most = outcomes.empty() ? 0 : outcomes[slowest].seconds;
+
+        std::ostringstream os;
+        os << std::fixed << where << ": stress: " << output.context() << ": " << expr << ": "
+           << ops << " ops in " << std::setprecision( 1 ) << 1000 * seconds << " ms, "
+           << std::setprecision( 0 ) << ( seconds > 0 ? static_cast<double>( ops ) / seconds : 0.0 ) << " ops/s, "
+           << "imbalance " << ( mean > 0 ? 100 * ( most - mean ) / mean : 0.0 ) << "%"
+           << " (fastest thread " << fastest << ", slowest thread " << slowest << ")\n";
+
+        for ( std::size_t t = 0; t < outcomes.size(); ++t )
+        {
+            os << "  thread " << t << ": " << outcomes[t].done << " ops in " << std::setprecision( 1 ) << 1000 * outcomes[t].seconds << " ms\n";
+        }
+        return os.str();
+    }
+
+    env & output;
+    location where;
+    text expr;
+    int threads;
+    int iterations;
+};
+
+struct times : action
+{
+    env output;
+    std::unique_ptr<async_report> reporter;
+    int selected = 0;
+    int failures = 0;
+
+    timer total;
+
+    times( std::ostream & out, options option )
+    : action( out ), output( out, option ), reporter( make_reporter( output ) ), total()
+    {
+        os << std::setfill(' ') << std::fixed << std::setprecision( lest_FEATURE_TIME_PRECISION );
+    }
+
+    operator int() { return failures; }
+
+    bool abort() { return output.abort() && failures > 0; }
+
+    times & operator()( test testing )
+    {
+        const std::size_t logged = fixtures().logged();
+
+        timer t;
+
+        try
+        {
+            perform( testing, output( testing.name ) );
+        }
+        catch( message const & )
+        {
+            ++failures;
+        }
+
+        const double elapsed = t.elapsed_seconds();
+
+        fixtures().finished( testing.name );
+
+        // fixture setup and teardown apart from the test's own time:
+
+        double setup = 0;
+        std::ostringstream line; line.copyfmt( os );
+
+        for ( auto const & r : fixtures().since( logged ) )
+        {
+            if ( r.what == "setup" )
+                setup += r.seconds;
+
+            line << std::setw(3) << ( 1000 * r.seconds ) << " ms: fixture " << r.name << " (" << r.what << ")\n";
+        }
+        line << std::setw(3) << ( 1000 * ( elapsed - setup ) ) << " ms: " << testing.name  << "\n";
+        report( output, event( line.str() ) );
+
+        return *this;
+    }
+
+    ~times()
+    {
+        if ( reporter ) reporter->stop();
+
+        os << "Elapsed time: " << std::setprecision(1) << total.elapsed_seconds() << " s\n";
+    }
+};
+
+// Threads that run tasks during a run of the tests, so that a test whose
+// sections run in parallel doesn't start threads of its own:
+
+class worker_pool
+{
+public:
+    explicit worker_pool( int threads )
+    : done( false )
+    {
+        for ( int i = 0; i < threads; ++i )
+            workers.emplace_back( [this]() { work(); } );
+    }
+
+    worker_pool( worker_pool const & ) = delete;
+    void operator=( worker_pool const & ) = delete;
+
+    ~worker_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            done = true;
+        }
+        ready.notify_all();
+
+        for ( auto & t : workers )
+            t.join();
+    }
+
+    int size() const { return static_cast<int>( workers.size() ); }
+
+    void submit( std::function<void()> task )
+    {
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            tasks.push_back( std::move( task ) );
+        }
+        ready.notify_one();
+    }
+
+private:
+    void work()
+    {
+        std::unique_lock<std::mutex> lock( mutex );
+
+        for (;;)
+        {
+            ready.wait( lock, [this]() { return done || ! tasks.empty(); } );
+
+            if ( tasks.empty() )
+                return;
+
+            std::function<void()> task = std::move( tasks.front() );
+            tasks.pop_front();
+
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque< std::function<void()> > tasks;
+    bool done;
+    std::vector<std::thread> workers;
+};
+
+// Run the section paths of a test on the threads of the pool and this thread,
+// for option --section-jobs. A run follows the exact path of a node and
+// collects the sections just beyond it without entering them, which become
+// the node's children; a run that finds none was a complete run of its path.
+// The run of the test itself happens on this thread; only when it finds
+// sections do the others join in. Each run has its own env and writes its
+// reports to a buffer; the buffers are written in tree order. Unlike a
+// sequential run, a failure does not stop the other paths. Returns whether
+// all runs passed; failed_path() is the path of the first failing run:
+
+class section_runner
+{
+public:
+    section_runner( test const & testing_, env & output_, worker_pool & pool_ )
+    : testing( testing_ ), output( output_ ), pool( pool_ ), active( 0 ), helpers( 0 ) {}
+
+    bool operator()()
+    {
+        nodes.push_back( node() );
+        visit( 0 );
+
+        if ( ! queue.empty() )
+        {
+            const int count = (std::min)( pool.size(), static_cast<int>( queue.size() ) );
+
+            helpers = count;
+
+            for ( int i = 0; i < count; ++i )
+                pool.submit( [this]() { work(); leave(); } );
+
+            work();
+
+            std::unique_lock<std::mutex> lock( mutex );
+            ready.wait( lock, [this]() { return helpers == 0; } );
+        }
+
+        bool passed = true;
+        std::exception_ptr error;
+
+        write( 0, passed, error );
+
+        if ( error )
+            std::rethrow_exception( error );
+
+        return passed;
+    }
+
+    texts const & failed_path() const { return failed_path_; }
+
+private:
+    struct node
+    {
+        texts path;
+        std::vector<std::size_t> children;
+        text report;
+        bool failed = false;
+        std::exception_ptr error;
+    };
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock( mutex );
+
+        for (;;)
+        {
+            ready.wait( lock, [this]() { return ! queue.empty() || active == 0; } );
+
+            if ( queue.empty() )
+                return;
+
+            const std::size_t index = queue.back();
+            queue.pop_back(); ++active;
+
+            lock.unlock();
+            visit( index );
+            lock.lock();
+
+            --active;
+            ready.notify_all();
+        }
+    }
+
+    void leave()
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        --helpers;
+        ready.notify_all();
+    }
+
+    // run the test along the path of the node, queue the sections it found:
+
+    void visit( std::size_t index )
+    {
+        texts path;
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            path = nodes[index].path;
+        }
+
+        std::ostringstream buffer;
+        env quiet( buffer, output.opt );
+        texts found;
+        bool failed = false;
+        std::exception_ptr error;
+
+        quiet.opt.section = path;
+        quiet.opt.leaks   = false;
+        quiet.listing = &found;
+
+        try
+        {
+            perform( testing, quiet( testing.name ) );
+        }
+        catch ( message const & e )
+        {
+            failed = true; report( quiet, e );
+        }
+        catch ( ... )
+        {
+            error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock( mutex );
+
+        nodes[index].report = buffer.str();
+        nodes[index].failed = failed;
+        nodes[index].error  = error;
+
+        for ( auto & name : found )
+        {
+            if ( failed || error )
+                break;
+
+            nodes.push_back( node() );
+            nodes.back().path = path;
+            nodes.back().path.push_back( name );
+
+            nodes[index].children.push_back( nodes.size() - 1 );
+            queue.push_back( nodes.size() - 1 );
+        }
+    }
+
+    void write( std::size_t index, bool & passed, std::exception_ptr & error )
+    {
+        node const & n = nodes[index];
+
+        if ( ! n.report.empty() )
+            report( output, event( n.report ) );
+
+        if ( n.failed && passed )
+            failed_path_ = n.path;
+
+        passed = passed && ! n.failed;
+
+        if ( n.error && ! error )
+            error = n.error;
+
+        for ( auto child : n.children )
+            write( child, passed, error );
+    }
+
+    test const & testing;
+    env & output;
+    worker_pool & pool;
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<node> nodes;
+    std::vector<std::size_t> queue;
+    std::size_t active;
+    int helpers;
+    texts failed_path_;
+};
+
+struct confirm : action
+{
+    env output;
+    std::unique_ptr<async_report> reporter;
+    std::unique_ptr<worker_pool> pool;
+    int selected = 0;
+    int failures = 0;
+    texts failed_path;      // the sections of the last failure
+
+    confirm( std::ostream & out, options option )
+    : action( out ), output( out, option ), reporter( make_reporter( output ) )
+    , pool( option.section_jobs > 1 && option.section.empty() ? new worker_pool( option.section_jobs - 1 ) : nullptr ) {}
+
+    operator int() { return failures; }
+
+    bool abort() { return output.abort() && failures > 0; }
+
+    confirm & operator()( test testing )
+    {
+        try
+        {
+            ++selected;
+
+            if ( pool )
+            {
+                section_runner runner( testing, output( testing.name ), *pool );
+
+                if ( ! runner() )
+                {
+                    ++failures; failed_path = runner.failed_path();
+                }
+            }
+            else
+            {
+                perform( testing, output( testing.name ) );
+            }
+        }
+        catch( message const & e )
+        {
+            ++failures; failed_path = output.path(); report( output, e );
+        }
+        fixtures().finished( testing.name );
+        return *this;
+    }
+
+    ~confirm()
+    {
+        if ( reporter ) reporter->stop();
+
+        if ( failures > 0 )
+        {
+            os << failures << " out of " << selected << " selected " << pluralise("test", selected) << " " << colourise( "failed.\n" );
+        }
+        else if ( output.pass() )
+        {
+            os << "All " << selected << " selected " << pluralise("test", selected) << " " << colourise( "passed.\n" );
+        }
+    }
+};
+
+// Option --flaky-scan=n: run each selected test n times on option.jobs threads,
+// in an order shuffled over all runs. A test runs on one thread at a time, so
+// only different tests run concurrently and these must be thread-safe. Report
+// per test how often it passed and the spread of its duration, and list the
+// tests that both passed and failed in a TSV file, to quarantine them:
+
+struct flaky_scan : action
+{
+    options opt;
+    tests selected;
+    int jobs;
+
+    flaky_scan( std::ostream & out, options option )
+    : action( out ), opt( option ), selected(), jobs( option.jobs )
+    {
+        opt.pass = opt.zen = opt.verbose = opt.abort = opt.async = false;
+        opt.jobs = 1;
+        opt.leaks = opt.leaks && jobs == 1;
+    }
+
+    flaky_scan & operator()( test testing ) { selected.push_back( testing ); return *this; }
+
+    operator int()
+    {
+        std::vector<std::size_t> schedule;
+
+        for ( int run = 0; run < opt.flaky; ++run )
+            for ( std::size_t i = 0; i < selected.size(); ++i )
+                schedule.push_back( i );
+
+        std::shuffle( schedule.begin(), schedule.end(), std::mt19937( opt.seed ) );
+
+        std::vector< std::vector<double> > durations( selected.size() );
+        std::vector<int> passed( selected.size(), 0 );
+        std::vector<bool> busy( selected.size(), false );
+        std::mutex mutex;
+        std::condition_variable idle;
+
+        std::size_t first = 0;
+        const std::size_t taken = selected.size();
+
+        // the first scheduled run of a test that no other thread runs:
+
+        auto take = [&]( std::size_t & k )
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+
+            for ( ;; )
+            {
+                while ( first < schedule.size() && schedule[first] == taken )
+                    ++first;
+
+                if ( first == schedule.size() )
+                    return false;
+
+                for ( std::size_t i = first; i < schedule.size(); ++i )
+                {
+                    if ( schedule[i] != taken && ! busy[ schedule[i] ] )
+                    {
+                        k = schedule[i]; busy[k] = true; schedule[i] = taken;
+                        return true;
+                    }
+                }
+                idle.wait( lock );
+            }
+        };
+
+        auto worker = [&]()
+        {
+            std::ostream discard( nullptr );
+            env quiet( discard, opt );
+
+            for ( std::size_t k = 0; take( k ); )
+            {
+                bool ok = true;
+                timer t;
+
+                try
+                {
+                    perform( selected[k], quiet( selected[k].name ) );
+                }
+                catch ( ... )
+                {
+                    ok = false;
+                }
+
+                const double elapsed = t.elapsed_seconds();
+
+                {
+                    std::lock_guard<std::mutex> lock( mutex );
+                    durations[k].push_back( elapsed );
+                    passed[k] += ok;
+                    busy[k] = false;
+                }
+                idle.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        const std::size_t threads = (std::min)( static_cast<std::size_t>( jobs ), selected.size() );
 
-    env( std::ostream & out, options option )
-    : os( out ), opt( option ), testing(), ctx() {}
+        for ( std::size_t i = 1; i < threads; ++i )
+            workers.emplace_back( worker );
 
-    env & operator()( text test )
-    {
-        clear(); testing = test; return *this;
-    }
+        worker();
 
-    bool abort() { return opt.abort; }
-    bool pass()  { return opt.pass; }
-    bool zen()   { return opt.zen; }
+        for ( auto & w : workers )
+            w.join();
+
+        // the scan is over: let suite fixtures go as confirm() would, as each
+        // selected test had its share of the runs the fixtures were counted for:
 
-    void clear() { ctx.clear(); }
-    void pop()   { ctx.pop_back(); }
-    void push( text proposition ) { ctx.emplace_back( proposition ); }
+        for ( auto & testing : selected )
+            for ( int r = 0; r < (std::max)( 1, opt.repeat ); ++r )
+                fixtures().finished( testing.name );
+
+        return summary( durations, passed );
+    }
 
-    text context() { return testing + sections(); }
+private:
+    //  flaky  7/10 passed, median 1.2 ms (0.9 .. 4.1 ms): name
 
-    text sections()
+    int summary( std::vector< std::vector<double> > & durations, std::vector<int> const & passed )
     {
-        if ( ! opt.verbose )
-            return "";
+        std::ostringstream lines;
+        std::ostringstream list;
+
+        int flaky = 0, failing = 0;
+
+        lines << std::fixed << std::setprecision( 1 );
+
+        for ( std::size_t k = 0; k < selected.size(); ++k )
+        {
+            std::vector<double> & d = durations[k];
+            std::sort( d.begin(), d.end() );
+
+            const bool fails = passed[k] == 0;
+            const bool flakes = ! fails && passed[k] < opt.flaky;
+
+            flaky += flakes; failing += fails;
+
+            lines << ( flakes ? "flaky  " : fails ? "fails  " : "passes " )
+               << std::setw(3) << passed[k] << "/" << opt.flaky << " passed, median " << 1000 * d[ d.size() / 2 ] << " ms"
+               << " (" << 1000 * d.front() << " .. " << 1000 * d.back() << " ms): " << selected[k].name << "\n";
 
-        text msg;
-        for( auto section : ctx )
+            if ( flakes )
+                list << selected[k].name << "\t" << passed[k] << "\t" << opt.flaky << "\n";
+        }
+
+        os << lines.str() << flaky << " flaky and " << failing << " failing out of " << selected.size() << " selected " << pluralise( "test", static_cast<int>( selected.size() ) )
+           << " (" << opt.flaky << " " << pluralise( "run", opt.flaky ) << " each)";
+
+        // the list only when there's something to quarantine or it's asked for:
+
+        if ( flaky > 0 || ! opt.flaky_list.empty() )
         {
-            msg += "\n  " + section;
+            const text path = opt.flaky_list.empty() ? "flaky.tsv" : opt.flaky_list;
+
+            std::ofstream file( path.c_str() );
+            file << "# test\tpassed\truns\n" << list.str();
+
+            if ( ! file )
+                throw std::runtime_error( "cannot write list of flaky tests to '" + path + "'" );
+
+            os << "; flaky tests listed in " << path;
         }
-        return msg;
+        os << "\n";
+
+        return flaky + failing;
     }
 };
 
-struct ctx
+// Option --repeat-until-fail reports a token for its first failure, which
+// option --replay=token uses to run the tests up to that test, to the same
+// repetition and along the same sections, in the same order and with the same seed.
+// The token reads order-seed-repetition-position-hash-path, where hash is
+// that of the test's name and path holds the hex-encoded section names:
+
+inline text name_hash( text const & name )
 {
-    env & environment;
-    bool once;
+    const std::uint64_t hash = fnv1a( reinterpret_cast<unsigned char const *>( name.data() ), name.size() );
 
-    ctx( env & environment_, text proposition_ )
-    : environment( environment_), once( true )
-    {
-        environment.push( proposition_);
-    }
+    text result;
+    for ( int shift = 28; shift >= 0; shift -= 4 )
+        result += hex_digits()[ ( hash >> shift ) & 0xf ];
 
-    ~ctx()
+    return result;
+}
+
+inline text replay_token( options const & option, int repetition, std::size_t index, text const & name, texts const & path )
+{
+    text hex;
+    for ( std::size_t i = 0; i < path.size(); ++i )
     {
-#if lest_CPP17_OR_GREATER
-        if ( std::uncaught_exceptions() == 0 )
-#else
-        if ( ! std::uncaught_exception() )
-#endif
+        if ( i > 0 )
+            hex += "00";
+
+        for ( char chr : path[i] )
         {
-            environment.pop();
+            const unsigned char c = static_cast<unsigned char>( chr );
+            hex += hex_digits()[ c >> 4 ]; hex += hex_digits()[ c & 0xf ];
         }
     }
 
-    explicit operator bool() { bool result = once; once = false; return result; }
-};
+    return text( option.random ? "r" : option.lexical ? "l" : "d" )
+        + "-" + to_string( option.seed ) + "-" + to_string( repetition ) + "-" + to_string( index ) + "-" + name_hash( name ) + "-" + hex;
+}
 
-struct action
+inline int repeat_until_fail( tests const & specification, texts const & in, std::ostream & os, options option )
 {
-    std::ostream & os;
+    text token;
+    int failures = 0;
+    {
+        confirm perform( os, option );
 
-    action( std::ostream & out ) : os( out ) {}
+        for ( int repetition = 0; token.empty(); ++repetition )
+        {
+            bool selected = false;
 
-    action( action const & ) = delete;
-    void operator=( action const & ) = delete;
+            for ( std::size_t i = 0; i < specification.size() && token.empty(); ++i )
+            {
+                if ( ! select( specification[i].name, in ) )
+                    continue;
 
-    operator      int() { return 0; }
-    bool        abort() { return false; }
-    action & operator()( test ) { return *this; }
-};
+                selected = true;
+                perform( specification[i] );
 
-struct print : action
-{
-    print( std::ostream & out ) : action( out ) {}
+                if ( perform.failures > 0 )
+                    token = replay_token( option, repetition, i, specification[i].name, perform.failed_path );
+            }
 
-    print & operator()( test testing )
-    {
-        os << testing.name << "\n"; return *this;
+            if ( ! selected )
+                break;
+        }
+        failures = perform;
     }
-};
-
-inline texts tags( text name, texts result = {} )
-{
-    auto none = std::string::npos;
-    auto lb   = name.find_first_of( "[" );
-    auto rb   = name.find_first_of( "]" );
-
-    if ( lb == none || rb == none )
-        return result;
 
-    result.emplace_back( name.substr( lb, rb - lb + 1 ) );
+    if ( ! token.empty() )
+        os << "Replay with option --replay=" << token << "\n";
 
-    return tags( name.substr( rb + 1 ), result );
+    return failures;
 }
 
-struct ptags : action
-{
-    std::set<text> result;
+// Replay first reruns, without output, the selected tests that ran before the
+// failure: all of them in earlier repetitions, and those before the test in its
+// own repetition. Only then it runs the test along the path of sections:
 
-    ptags( std::ostream & out ) : action( out ), result() {}
+inline int replay( tests const & specification, texts const & in, std::ostream & os, options option )
+{
+    replay_point const & at = option.replay;
 
-    ptags & operator()( test testing )
+    if ( at.index >= specification.size() || name_hash( specification[ at.index ].name ) != at.hash )
+        throw std::runtime_error( "replay token doesn't match the tests (use the same test program)" );
     {
-        for ( auto & tag : tags( testing.name ) )
-            result.insert( tag );
+        options quiet = option;
+        quiet.pass = quiet.zen = quiet.verbose = quiet.abort = quiet.async = false;
+        quiet.replay.active = false;
+        quiet.section.clear();
 
-        return *this;
-    }
+        std::ostream discard( nullptr );
+        confirm prefix( discard, quiet );
 
-    ~ptags()
-    {
-        std::copy( result.begin(), result.end(), std::ostream_iterator<text>( os, "\n" ) );
+        for ( int repetition = 0; repetition <= at.repetition; ++repetition )
+        {
+            for ( std::size_t i = 0; i < specification.size(); ++i )
+            {
+                if ( repetition == at.repetition && i == at.index )
+                    break;
+
+                if ( select( specification[i].name, in ) )
+                    prefix( specification[i] );
+            }
+        }
     }
-};
 
-struct count : action
-{
-    int n = 0;
+    confirm perform( os, option );
 
-    count( std::ostream & out ) : action( out ) {}
+    perform( specification[ at.index ] );
 
-    count & operator()( test ) { ++n; return *this; }
+    return perform;
+}
 
-    ~count()
-    {
-        os << n << " selected " << pluralise("test", n) << "\n";
-    }
-};
+// Option --bisect=name: find the smallest set of the tests that precede the
+// named test in the selected order, for which the named test fails. Each
+// candidate sequence runs in a forked process, so that its tests start from
+// clean global state; option.jobs processes run at a time. The set shrinks
+// by delta debugging: try subsets, then complements, with ever finer parts.
 
-struct timer
-{
-    using time = std::chrono::high_resolution_clock;
+#if lest_HAVE_POSIX && lest_FEATURE_PROCESS
 
-    time::time_point start = time::now();
+using indices = std::vector<std::size_t>;
 
-    double elapsed_seconds() const
+class bisection
+{
+public:
+    bisection( tests const & selected_, std::size_t target_, options option_ )
+    : selected( selected_ ), target( target_ ), option( option_ ), runs( 0 )
     {
-        return 1e-6 * static_cast<double>( std::chrono::duration_cast< std::chrono::microseconds >( time::now() - start ).count() );
+        option.pass = option.zen = option.verbose = option.abort = option.async = false;
     }
-};
 
-struct times : action
-{
-    env output;
-    int selected = 0;
-    int failures = 0;
+    int run_count() const { return runs; }
 
-    timer total;
+    // whether the target test fails after each of the sequences:
 
-    times( std::ostream & out, options option )
-    : action( out ), output( out, option ), total()
+    std::vector<int> fails( std::vector<indices> const & sequences )
     {
-        os << std::setfill(' ') << std::fixed << std::setprecision( lest_FEATURE_TIME_PRECISION );
-    }
+        std::vector<int> result( sequences.size(), 0 );
+        const std::size_t jobs = static_cast<std::size_t>( (std::max)( 1, option.jobs ) );
 
-    operator int() { return failures; }
+        for ( std::size_t first = 0; first < sequences.size(); first += jobs )
+        {
+            const std::size_t last = (std::min)( first + jobs, sequences.size() );
+            std::vector<long> pids;
 
-    bool abort() { return output.abort() && failures > 0; }
+            for ( std::size_t i = first; i < last; ++i )
+                pids.push_back( spawn( sequences[i] ) );
 
-    times & operator()( test testing )
+            for ( std::size_t i = first; i < last; ++i )
+                result[i] = wait( pids[ i - first ] );
+        }
+        runs += static_cast<int>( sequences.size() );
+        return result;
+    }
+
+    indices minimize( indices set )
     {
-        timer t;
+        std::size_t n = 2;
 
-        try
+        while ( set.size() >= 2 )
         {
-            testing.behaviour( output( testing.name ) );
+            std::vector<indices> candidates = split( set, n );
+            const std::size_t parts = candidates.size();
+
+            if ( parts > 2 )
+            {
+                for ( std::size_t i = 0; i < parts; ++i )
+                    candidates.push_back( without( set, candidates[i] ) );
+            }
+
+            const std::vector<int> failing = fails( candidates );
+            const std::size_t found = static_cast<std::size_t>( std::find( failing.begin(), failing.end(), 1 ) - failing.begin() );
+
+            if      ( found < parts               ) { set = candidates[found]; n = 2; }
+            else if ( found < candidates.size()   ) { set = candidates[found]; n = (std::max)( n - 1, std::size_t( 2 ) ); }
+            else if ( n >= set.size()             ) { break; }
+            else                                    { n = (std::min)( 2 * n, set.size() ); }
         }
-        catch( message const & )
+        return set;
+    }
+
+private:
+    static std::vector<indices> split( indices const & set, std::size_t n )
+    {
+        std::vector<indices> parts;
+
+        for ( std::size_t i = 0, begin = 0; i < n; ++i )
         {
-            ++failures;
+            const std::size_t end = begin + ( set.size() - begin ) / ( n - i );
+            parts.push_back( indices( set.begin() + static_cast<std::ptrdiff_t>( begin ), set.begin() + static_cast<std::ptrdiff_t>( end ) ) );
+            begin = end;
         }
+        return parts;
+    }
 
-        os << std::setw(3) << ( 1000 * t.elapsed_seconds() ) << " ms: " << testing.name  << "\n";
+    static indices without( indices const & set, indices const & part )
+    {
+        indices result;
+        std::set_difference( set.begin(), set.end(), part.begin(), part.end(), std::back_inserter( result ) );
+        return result;
+    }
 
-        return *this;
+    long spawn( indices const & sequence )
+    {
+        const pid_t pid = ::fork();
+
+        if ( pid < 0 )
+            throw std::runtime_error( "cannot start a process for option --bisect" );
+
+        if ( pid == 0 )
+        {
+            std::ostream discard( nullptr );
+            env quiet( discard, option );
+
+            for ( auto i : sequence )
+            {
+                try { perform( selected[i], quiet( selected[i].name ) ); } catch ( ... ) {}
+            }
+
+            try { perform( selected[target], quiet( selected[target].name ) ); } catch ( ... ) { ::_exit( 1 ); }
+
+            ::_exit( 0 );
+        }
+        return static_cast<long>( pid );
     }
 
-    ~times()
+    // a crash counts as failure:
+
+    static int wait( long pid )
     {
-        os << "Elapsed time: " << std::setprecision(1) << total.elapsed_seconds() << " s\n";
+        int status = 0;
+        ::waitpid( static_cast<pid_t>( pid ), &status, 0 );
+
+        return ! ( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 );
     }
+
+    tests const & selected;
+    std::size_t target;
+    options option;
+    int runs;
 };
 
-struct confirm : action
+inline int bisect( tests const & specification, texts const & in, std::ostream & os, options option )
 {
-    env output;
-    int selected = 0;
-    int failures = 0;
+    tests selected;
+    for ( auto & testing : specification )
+    {
+        if ( select( testing.name, in ) )
+            selected.push_back( testing );
+    }
 
-    confirm( std::ostream & out, options option )
-    : action( out ), output( out, option ) {}
+    // the test of that name, or the only one that contains it:
 
-    operator int() { return failures; }
+    std::size_t target = selected.size();
+    std::size_t matches = 0;
 
-    bool abort() { return output.abort() && failures > 0; }
+    for ( std::size_t i = 0; i < selected.size(); ++i )
+    {
+        if ( selected[i].name == option.bisect ) { target = i; matches = 1; break; }
+        if ( search( option.bisect, selected[i].name ) ) { target = i; ++matches; }
+    }
 
-    confirm & operator()( test testing )
+    if ( matches != 1 )
+        throw std::runtime_error( "option --bisect: " + to_string( matches ) + " selected tests match '" + option.bisect + "'" );
+
+    text const & name = selected[target].name;
+
+    indices prefix;
+    for ( std::size_t i = 0; i < target; ++i )
+        prefix.push_back( i );
+
+    bisection bisector( selected, target, option );
+
+    const std::vector<int> failing = bisector.fails( { indices(), prefix } );
+
+    if ( failing[0] )
     {
-        try
-        {
-            ++selected; testing.behaviour( output( testing.name ) );
-        }
-        catch( message const & e )
-        {
-            ++failures; report( os, e, output.context() );
-        }
-        return *this;
+        os << name << ": fails on its own\n";
+        return 1;
     }
 
-    ~confirm()
+    if ( ! failing[1] )
     {
-        if ( failures > 0 )
-        {
-            os << failures << " out of " << selected << " selected " << pluralise("test", selected) << " " << colourise( "failed.\n" );
-        }
-        else if ( output.pass() )
-        {
-            os << "All " << selected << " selected " << pluralise("test", selected) << " " << colourise( "passed.\n" );
-        }
+        os << name << ": passes after the " << prefix.size() << " preceding " << pluralise( "test", static_cast<int>( prefix.size() ) ) << "\n";
+        return 0;
     }
+
+    const indices culprits = bisector.minimize( prefix );
+
+    os << name << ": fails after " << culprits.size() << " of the " << prefix.size() << " preceding " << pluralise( "test", static_cast<int>( prefix.size() ) )
+       << " (" << bisector.run_count() << " runs):\n";
+
+    for ( auto i : culprits )
+        os << "  " << selected[i].name << "\n";
+
+    return 1;
+}
+
+#endif // lest_HAVE_POSIX && lest_FEATURE_PROCESS
+
+// fixtures of the selected tests during a run:
+
+struct fixture_run
+{
+    fixture_run( tests const & specification, texts const & in, int repeat ) { fixtures().start( specification, in, repeat ); }
+    ~fixture_run() { fixtures().stop(); }
 };
 
 template< typename Action >
@@ -1313,6 +5831,97 @@ inline int repeat( text opt, text arg )
     throw std::runtime_error( "expecting '-1' or positive number with option '" + opt + "', got '" + arg + "' (try option --help)" );
 }
 
+inline int positive( text opt, text arg )
+{
+    const int num = lest::stoi( arg );
+
+    if ( is_number( arg ) && num > 0 )
+        return num;
+
+    throw std::runtime_error( "expecting positive number with option '" + opt + "', got '" + arg + "' (try option --help)" );
+}
+
+inline text bisect_name( text name )
+{
+#if lest_HAVE_POSIX && lest_FEATURE_PROCESS
+    return name;
+#else
+    (void) name;
+    throw std::runtime_error( "option --bisect requires POSIX fork() and lest_FEATURE_PROCESS" );
+#endif
+}
+
+inline bool leak_check()
+{
+#if lest_HAVE_PROCFS
+    return true;
+#else
+    throw std::runtime_error( "option --check-leaks requires Linux and lest_FEATURE_PROCESS" );
+#endif
+}
+
+inline void parse_replay( text token, options & option )
+{
+    auto invalid = [&]() { return std::runtime_error( "invalid token '" + token + "' with option --replay (try option --help)" ); };
+
+    texts fields( 1 );
+    for ( char chr : token )
+    {
+        if ( chr == '-' ) fields.emplace_back();
+        else              fields.back() += chr;
+    }
+
+    auto number = []( text const & field ) { return ! field.empty() && is_number( field ); };
+
+    if ( fields.size() != 6 || ( fields[0] != "d" && fields[0] != "l" && fields[0] != "r" )
+        || ! number( fields[1] ) || ! number( fields[2] ) || ! number( fields[3] ) || fields[4].size() != 8 || fields[5].size() % 2 != 0 )
+        throw invalid();
+
+    auto nibble = [&]( char chr ) -> int
+    {
+        char const * pos = std::strchr( hex_digits(), chr );
+        if ( chr == '\0' || pos == nullptr )
+            throw invalid();
+        return static_cast<int>( pos - hex_digits() );
+    };
+
+    texts path( fields[5].empty() ? 0 : 1 );
+    for ( std::size_t i = 0; i < fields[5].size(); i += 2 )
+    {
+        const char chr = static_cast<char>( 16 * nibble( fields[5][i] ) + nibble( fields[5][i + 1] ) );
+
+        if ( chr == '\0' ) path.emplace_back();
+        else               path.back() += chr;
+    }
+
+    option.lexical = fields[0] == "l";
+    option.random  = fields[0] == "r";
+    option.seed    = static_cast<seed_t>( std::strtoul( fields[1].c_str(), nullptr, 10 ) );
+    option.section = path;
+    option.replay.active     = true;
+    option.replay.repetition = lest::stoi( fields[2] );
+    option.replay.index      = static_cast<std::size_t>( std::strtoul( fields[3].c_str(), nullptr, 10 ) );
+    option.replay.hash       = fields[4];
+}
+
+// "name/subname" into its non-empty components:
+
+inline texts split_path( text arg )
+{
+    texts result;
+
+    for ( std::size_t pos = 0; pos <= arg.size(); )
+    {
+        const std::size_t end = (std::min)( arg.find( '/', pos ), arg.size() );
+
+        if ( end > pos )
+            result.push_back( arg.substr( pos, end - pos ) );
+
+        pos = end + 1;
+    }
+    return result;
+}
+
 inline auto split_option( text arg ) -> std::tuple<text, text>
 {
     auto pos = arg.rfind( '=' );
@@ -1347,11 +5956,30 @@ inline auto split_arguments( texts args ) -> std::tuple<options, texts>
             else if ( opt == "-z"      || "--pass-zen"   == opt ) { option.zen     =  true; continue; }
             else if ( opt == "-v"      || "--verbose"    == opt ) { option.verbose =  true; continue; }
             else if (                     "--version"    == opt ) { option.version =  true; continue; }
+            else if (                     "--async-report" == opt ) { option.async = true; continue; }
+            else if (                     "--list-sections" == opt ) { option.sections = true; continue; }
+            else if ( opt == "--section"     ) { option.section = split_path( val ); continue; }
             else if ( opt == "--order" && "declared"     == val ) { /* by definition */   ; continue; }
             else if ( opt == "--order" && "lexical"      == val ) { option.lexical =  true; continue; }
             else if ( opt == "--order" && "random"       == val ) { option.random  =  true; continue; }
             else if ( opt == "--random-seed" ) { option.seed   = seed  ( "--random-seed", val ); continue; }
             else if ( opt == "--repeat"      ) { option.repeat = repeat( "--repeat"     , val ); continue; }
+            else if ( opt == "--property-cases" ) { option.cases = positive( "--property-cases", val ); continue; }
+            else if ( opt == "--jobs"        ) { option.jobs   = positive( "--jobs"       , val ); continue; }
+            else if ( opt == "--section-jobs" ) { option.section_jobs = positive( "--section-jobs", val ); continue; }
+#if lest_FEATURE_FUZZ
+            else if ( opt == "--fuzz"        ) { option.fuzz   = positive( "--fuzz"       , val ); continue; }
+            else if ( opt == "--fuzz-corpus"    ) { option.corpus    = val; continue; }
+            else if ( opt == "--fuzz-artifacts" ) { option.artifacts = val; continue; }
+            else if (        "--fuzz-minimize"  == opt ) { option.minimize = true; continue; }
+#endif
+            else if (        "--pin-threads"    == opt ) { option.pin      = true; continue; }
+            else if ( opt == "--flaky-scan"  ) { option.flaky  = positive( "--flaky-scan" , val ); continue; }
+            else if ( opt == "--flaky-list"  ) { option.flaky_list = val; continue; }
+            else if (        "--repeat-until-fail" == opt ) { option.until_fail = true; continue; }
+            else if ( opt == "--replay"      ) { parse_replay( val, option ); continue; }
+            else if ( opt == "--bisect"      ) { option.bisect = bisect_name( val ); continue; }
+            else if (        "--check-leaks"    == opt ) { option.leaks    = leak_check(); continue; }
             else throw std::runtime_error( "unrecognised option '" + arg + "' (try option --help)" );
         }
         in.push_back( arg );
@@ -1372,16 +6000,35 @@ inline int usage( std::ostream & os )
         "  -c, --count        count selected tests\n"
         "  -g, --list-tags    list tags of selected tests\n"
         "  -l, --list-tests   list selected tests\n"
+        "  --list-sections    list the sections of selected tests\n"
         "  -p, --pass         also report passing tests\n"
         "  -z, --pass-zen     ... without expansion\n"
         "  -t, --time         list duration of selected tests\n"
         "  -v, --verbose      also report passing or failing sections\n"
+        "  --section=path     run only the sections along path, e.g. \"name/subname\"\n"
+        "  --async-report     format and write reports on a background thread\n"
         "  --order=declared   use source code test order (default)\n"
         "  --order=lexical    use lexical sort test order\n"
         "  --order=random     use random test order\n"
         "  --random-seed=n    use n for random generator seed\n"
         "  --random-seed=time use time for random generator seed\n"
         "  --repeat=n         repeat selected tests n times (-1: indefinite)\n"
+        "  --repeat-until-fail repeat selected tests until one fails, report a replay token\n"
+        "  --replay=token     quietly rerun the tests before the failure of a replay token, then run its test\n"
+        "  --bisect=name      find the preceding tests that make test name fail (POSIX)\n"
+        "  --check-leaks      fail tests that leave file descriptors or threads behind (Linux)\n"
+        "  --property-cases=n generate n cases per property (default: " lest_STRINGIFY( lest_FEATURE_PROPERTY_CASES ) ")\n"
+        "  --jobs=n           run property cases and data rows on n threads (default: 1)\n"
+        "  --section-jobs=n   run the section paths of a test on n threads (default: 1)\n"
+#if lest_FEATURE_FUZZ
+        "  --fuzz=seconds     mutate inputs of fuzz cases for the given time\n"
+        "  --fuzz-corpus=path use the file or the files in directory path as inputs\n"
+        "  --fuzz-artifacts=dir save failing and crashing inputs in dir (default: .)\n"
+        "  --fuzz-minimize    minimize a failing input before saving it\n"
+#endif
+        "  --pin-threads      pin the threads of stress tests to processors (Linux)\n"
+        "  --flaky-scan=n     run each selected test n times in random order, on --jobs threads\n"
+        "  --flaky-list=path  list the flaky tests found in TSV file path (default: flaky.tsv, if any)\n"
         "  --version          report lest version and compiler used\n"
         "  --                 end options\n"
         "\n"
@@ -1422,7 +6069,10 @@ inline int version( std::ostream & os )
     return 0;
 }
 
-inline int run( tests specification, texts arguments, std::ostream & os = std::cout )
+lest_INLINE int run( tests specification, texts arguments, std::ostream & os = std::cout );
+lest_INLINE int run( tests specification, int argc, char * argv[], std::ostream & os = std::cout );
+
+lest_INLINE int run( tests specification, texts arguments, std::ostream & os )
 {
     try
     {
@@ -1437,7 +6087,17 @@ inline int run( tests specification, texts arguments, std::ostream & os = std::c
         if ( option.count   ) { return for_test( specification, in, count( os ) ); }
         if ( option.list    ) { return for_test( specification, in, print( os ) ); }
         if ( option.tags    ) { return for_test( specification, in, ptags( os ) ); }
+        if ( option.sections) { return for_test( specification, in, psections( os, option ) ); }
+
+        fixture_run scope( specification, in, option.time ? 1 : option.until_fail ? -1 : option.repeat );
+
+        if ( option.replay.active ) { return replay( specification, in, os, option ); }
+        if ( option.until_fail ) { return repeat_until_fail( specification, in, os, option ); }
+#if lest_HAVE_POSIX && lest_FEATURE_PROCESS
+        if ( ! option.bisect.empty() ) { return bisect( specification, in, os, option ); }
+#endif
         if ( option.time    ) { return for_test( specification, in, times( os, option ) ); }
+        if ( option.flaky   ) { return for_test( specification, in, flaky_scan( os, option ) ); }
 
         return for_test( specification, in, confirm( os, option ), option.repeat );
     }
@@ -1448,7 +6108,7 @@ inline int run( tests specification, texts arguments, std::ostream & os = std::c
     }
 }
 
-inline int run( tests specification, int argc, char * argv[], std::ostream & os = std::cout )
+lest_INLINE int run( tests specification, int argc, char * argv[], std::ostream & os )
 {
     return run( specification, texts( argv + 1, argv + argc ), os  );
 }
@@ -1472,6 +6132,8 @@ int run( test const (&specification)[N], int argc, char * argv[], std::ostream &
     return run( tests( specification, specification + N ), texts( argv + 1, argv + argc ), os  );
 }
 
+#endif // lest_HAVE_IMPLEMENTATION
+
 } // namespace lest
 
 #if defined (__clang__)
@@ -20,6 +20,8 @@
 #include <type_traits>
 #include <cstddef>
 
+#include "lest_format.hpp"
+
 #ifdef __clang__
 # pragma clang diagnostic ignored "-Waggregate-return"
 # pragma clang diagnostic ignored "-Woverloaded-shift-op-parentheses"
@@ -273,6 +275,17 @@ inline std::string to_string( std::string    const & txt ) { return "\"" + txt +
 inline std::string to_string( char const *   const & txt ) { return "\"" + std::string( txt ) + "\"" ; }
 inline std::string to_string( char           const & txt ) { return "\'" + std::string( 1, txt ) + "\'" ; }
 
+inline std::string to_string(   signed short        value ) { return make_number_string( value ); }
+inline std::string to_string( unsigned short        value ) { return make_number_string( value ); }
+inline std::string to_string(   signed   int        value ) { return make_number_string( value ); }
+inline std::string to_string( unsigned   int        value ) { return make_number_string( value ); }
+inline std::string to_string(   signed  long        value ) { return make_number_string( value ); }
+inline std::string to_string( unsigned  long        value ) { return make_number_string( value ); }
+inline std::string to_string(   signed  long long   value ) { return make_number_string( value ); }
+inline std::string to_string( unsigned  long long   value ) { return make_number_string( value ); }
+inline std::string to_string(         double        value ) { return make_number_string( value ); }
+inline std::string to_string(          float        value ) { return make_number_string( value ); }
+
 template<typename T>
 struct is_container
 {
@@ -0,0 +1,96 @@
+// Copyright 2013-2018 by Martin Moene
+//
+// lest is based on ideas by Kevlin Henney, see video at
+// http://skillsmatter.com/podcast/agile-testing/kevlin-henney-rethinking-unit-testing-in-c-plus-plus
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Numeric value formatting, shared by lest.hpp and lest_decompose.hpp.
+
+#ifndef LEST_LEST_FORMAT_HPP_INCLUDED
+#define LEST_LEST_FORMAT_HPP_INCLUDED
+
+#include <algorithm>
+#include <string>
+#include <type_traits>
+
+#include <cstddef>
+#include <cstdio>
+
+#ifndef  lest_FEATURE_TO_CHARS
+# define lest_FEATURE_TO_CHARS  1
+#endif
+
+// std::to_chars() for integral and floating point values requires a C++17 library:
+
+#if defined( _MSVC_LANG ) && ! defined( __clang__ )
+# define lest_FORMAT_CPLUSPLUS  _MSVC_LANG
+#else
+# define lest_FORMAT_CPLUSPLUS  __cplusplus
+#endif
+
+#if lest_FEATURE_TO_CHARS && lest_FORMAT_CPLUSPLUS >= 201703L && defined( __has_include )
+# if __has_include( <charconv> )
+#  include <charconv>
+# endif
+#endif
+
+#if lest_FEATURE_TO_CHARS && defined( __cpp_lib_to_chars )
+# define lest_HAVE_TO_CHARS  1
+#else
+# define lest_HAVE_TO_CHARS  0
+#endif
+
+namespace lest
+{
+
+#if ! lest_HAVE_TO_CHARS
+
+// printf-style conversion as std::ostream with default flags does it:
+
+inline int print_number( char * buf, std::size_t n,   signed short     value ) { return std::snprintf( buf, n, "%hd" , value ); }
+inline int print_number( char * buf, std::size_t n, unsigned short     value ) { return std::snprintf( buf, n, "%hu" , value ); }
+inline int print_number( char * buf, std::size_t n,   signed int       value ) { return std::snprintf( buf, n, "%d"  , value ); }
+inline int print_number( char * buf, std::size_t n, unsigned int       value ) { return std::snprintf( buf, n, "%u"  , value ); }
+inline int print_number( char * buf, std::size_t n,   signed long      value ) { return std::snprintf( buf, n, "%ld" , value ); }
+inline int print_number( char * buf, std::size_t n, unsigned long      value ) { return std::snprintf( buf, n, "%lu" , value ); }
+inline int print_number( char * buf, std::size_t n,   signed long long value ) { return std::snprintf( buf, n, "%lld", value ); }
+inline int print_number( char * buf, std::size_t n, unsigned long long value ) { return std::snprintf( buf, n, "%llu", value ); }
+inline int print_number( char * buf, std::size_t n,        float       value ) { return std::snprintf( buf, n, "%g"  , static_cast<double>( value ) ); }
+inline int print_number( char * buf, std::size_t n,        double      value ) { return std::snprintf( buf, n, "%g"  , value ); }
+inline int print_number( char * buf, std::size_t n,   long double      value ) { return std::snprintf( buf, n, "%Lg" , value ); }
+
+#endif
+
+// Integral (not bool, not character) or floating point value into [first, last),
+// which must provide room for at least 64 characters; returns the end of the text.
+// With std::to_chars(), floating point values use the shortest round-trip form:
+
+template< typename T >
+auto format_number( char * first, char * last, T value ) -> char *
+{
+    static_assert( std::is_arithmetic<T>::value, "format_number() requires an integral or floating point type" );
+
+#if lest_HAVE_TO_CHARS
+    const std::to_chars_result result = std::to_chars( first, last, value );
+
+    return result.ec == std::errc() ? result.ptr : first;
+#else
+    const int size = print_number( first, static_cast<std::size_t>( last - first ), value );
+
+    return size < 0 ? first : first + (std::min)( static_cast<std::ptrdiff_t>( size ), last - first - 1 );
+#endif
+}
+
+template< typename T >
+auto make_number_string( T value ) -> std::string
+{
+    char buffer[ 64 ];
+
+    return std::string( buffer, format_number( buffer, buffer + sizeof buffer, value ) );
+}
+
+} // namespace lest
+
+#endif // LEST_LEST_FORMAT_HPP_INCLUDED
@@ -0,0 +1,365 @@
+#!/usr/bin/env python
+#
+# Copyright 2013-2018 by Martin Moene
+#
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#
+# script/bench-compile.py, Python 3.4 and later
+#
+# Compile-time benchmark of the lest headers: generate a synthetic suite of test
+# translation units (cases of mixed-type assertions), build it as one program per
+# header variant and feature macro combination and record compile time, peak
+# compiler memory, object size and link time. Results are appended to a CSV file,
+# to track the build cost of lest from release to release. GCC and clang.
+#
+
+from __future__ import print_function
+
+import argparse
+import csv
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+# Configuration:
+
+cfg_include_folder = os.path.normpath( os.path.join( os.path.dirname( os.path.abspath( __file__ ) ), '../include' ) )
+
+variants = (
+    # name, header, definitions, registration, std (None: --std), capabilities
+    ( 'lest'          , 'lest.hpp'          , []                                 , 'module', None, 'approx container' ),
+    ( 'lest-split'    , 'lest.hpp'          , ['-Dlest_CONFIG_SPLIT=1']          , 'module', None, 'approx container implement' ),
+    ( 'lest-auto'     , 'lest.hpp'          , ['-Dlest_FEATURE_AUTO_REGISTER=1'] , 'auto'  , None, 'approx container' ),
+    ( 'lest-regex'    , 'lest.hpp'          , ['-Dlest_FEATURE_REGEX_SEARCH=1']  , 'module', None, 'approx container' ),
+    ( 'lest_decompose', 'lest_decompose.hpp', []                                 , 'array' , None, '' ),
+    ( 'lest_basic'    , 'lest_basic.hpp'    , []                                 , 'array' , None, '' ),
+    ( 'lest_cpp03'    , 'lest_cpp03.hpp'    , []                                 , 'auto'  , None, 'approx' ),
+    ( 'lest_cpp03-98' , 'lest_cpp03.hpp'    , []                                 , 'auto'  , '98', 'approx' ),
+)
+
+# assertions of mixed types, cycled through by the cases (C++98):
+
+assertions = (
+    'EXPECT( i + {k} == {n} + {k} );',
+    'EXPECT( s + "{k}" != "" );',
+    'EXPECT( d < {n} + 1.0 );',
+    'EXPECT( s.size() >= {k}u );',
+    'EXPECT( s[0] == \'c\' );',
+    { 'approx': 'EXPECT( d == lest::approx( {n}.5 ) );', '': 'EXPECT( d != 0.0 );' },
+    { 'container': 'EXPECT( v == v );', '': 'EXPECT( v.size() == 3u );' },
+    'EXPECT_THROWS( v.at( 7 ) );',
+)
+
+tpl_body = """\
+    {{
+        int i = {n}; double d = {n}.5; std::string s = "case {n}"; std::vector<int> v( 3, {n} );
+
+{assertions}    }}"""
+
+tpl_case = {
+    'module': '    CASE( "{name}" )\n{body},\n',
+    'array' : '    CASE( "{name}" )\n{body},\n',
+    'auto'  : 'lest_CASE( specification(), "{name}" )\n{body}\n\n',
+}
+
+tpl_tu = {
+    'module': """\
+#include "lest/{header}"
+#include <vector>
+
+const lest::test module[] =
+{{
+{cases}}};
+
+extern lest::tests & specification();
+
+MODULE( specification(), module )
+""",
+    'array': """\
+#include "lest/{header}"
+#include <vector>
+
+extern const lest::test module_{tu}[] =
+{{
+{cases}}};
+""",
+    'auto': """\
+#include "lest/{header}"
+#include <vector>
+
+extern lest::tests & specification();
+
+{cases}""",
+}
+
+tpl_main = {
+    'module': """\
+{config}#include "lest/{header}"
+
+lest::tests & specification()
+{{
+    static lest::tests tests;
+    return tests;
+}}
+
+int main( int argc, char * argv[] )
+{{
+    return lest::run( specification(), argc, argv );
+}}
+""",
+    'array': """\
+#include "lest/{header}"
+
+{modules}
+int main()
+{{
+    int failures = 0;
+{runs}    return failures;
+}}
+""",
+}
+
+tpl_main['auto'] = tpl_main['module']
+
+csv_fields = (
+    'lest', 'compiler', 'std', 'flags', 'variant', 'header', 'definitions', 'tus', 'cases', 'assertions',
+    'compile_s', 'compile_per_tu_s', 'peak_kb', 'main_s', 'main_peak_kb', 'object_bytes', 'link_s', 'program_bytes' )
+
+# End configuration.
+
+def readFile( in_path ):
+    """Return content of file at given path"""
+    with open( in_path, 'r' ) as in_file:
+        contents = in_file.read()
+    return contents
+
+def writeFile( out_path, contents ):
+    """Write contents to file at given path"""
+    with open( out_path, 'w' ) as out_file:
+        out_file.write( contents )
+
+def lestVersion():
+    """Version of lest.hpp"""
+    text = readFile( os.path.join( cfg_include_folder, 'lest/lest.hpp' ) )
+    return '.'.join( re.search( r'#define\s+lest_' + part + r'\s+([0-9]+)', text ).group(1) for part in ( 'MAJOR', 'MINOR', 'PATCH' ) )
+
+def compilerVersion( args ):
+    """Name and version of the compiler"""
+    try:
+        version = subprocess.check_output( [args.cxx, '-dumpversion'], universal_newlines=True ).strip()
+    except ( OSError, subprocess.CalledProcessError ):
+        version = '?'
+    return '{} {}'.format( os.path.basename( args.cxx ), version )
+
+def assertionsOf( case, capabilities, args ):
+    """The assertions of a case, given the capabilities of the variant"""
+    lines = ''
+    for k in range( args.assertions ):
+        tpl = assertions[ k % len( assertions ) ]
+        if isinstance( tpl, dict ):
+            tpl = tpl[ next( ( cap for cap in tpl if cap in capabilities.split() ), '' ) ]
+        lines += '        ' + tpl.format( n=case, k=k ) + '\n'
+    return lines
+
+def generateSuite( variant, folder, args ):
+    """Write the test translation units and main of a variant, return their paths"""
+    name, header, definitions, registration, std, capabilities = variant
+    sources = []
+    for tu in range( args.tus ):
+        cases = ''
+        for case in range( args.cases ):
+            body = tpl_body.format( n=case, assertions=assertionsOf( case, capabilities, args ) )
+            cases += tpl_case[registration].format( name='tu {} case {}'.format( tu, case ), body=body )
+        sources.append( os.path.join( folder, '{}_test_{}.cpp'.format( name, tu ) ) )
+        writeFile( sources[-1], tpl_tu[registration].format( header=header, tu=tu, cases=cases ) )
+
+    main = os.path.join( folder, '{}_main.cpp'.format( name ) )
+    writeFile( main, tpl_main[registration].format(
+        header=header,
+        config='#define lest_CONFIG_IMPLEMENT  1\n\n' if 'implement' in capabilities else '',
+        modules=''.join( 'extern const lest::test module_{}[{}];\n'.format( tu, args.cases ) for tu in range( args.tus ) ),
+        runs=''.join( '    failures += lest::run( module_{} );\n'.format( tu ) for tu in range( args.tus ) ) ) )
+
+    return sources, main
+
+def measured( cmd, args ):
+    """Run command, return its duration in seconds and its peak memory in kB (0 if unknown)"""
+    if args.verbose:
+        print( '> {}'.format( ' '.join( cmd ) ) )
+    start = time.time()
+    process = subprocess.Popen( cmd )
+    if hasattr( os, 'wait4' ):
+        # the rusage of the compiler driver includes the compiler proper it waited for:
+        _, status, usage = os.wait4( process.pid, 0 )
+        process.returncode = status
+        peak_kb = usage.ru_maxrss // 1024 if sys.platform == 'darwin' else usage.ru_maxrss
+    else:
+        process.wait()
+        status, peak_kb = process.returncode, 0
+    duration = time.time() - start
+    if status != 0:
+        sys.exit( 'bench-compile.py: command failed: {}'.format( ' '.join( cmd ) ) )
+    return duration, peak_kb
+
+def benchVariant( variant, folder, args ):
+    """Build the suite of a variant, return its measurements"""
+    name, header, definitions, registration, std, capabilities = variant
+    std = std if std else args.std
+    compile_cmd = [args.cxx, '-std=c++{}'.format( std ), '-I' + cfg_include_folder, '-c'] + args.flags.split() + definitions
+
+    sources, main = generateSuite( variant, folder, args )
+
+    compile_s, peak_kb, object_bytes = 0.0, 0, 0
+    objects = []
+    for source in sources:
+        objects.append( source[:-4] + '.o' )
+        duration, peak = measured( compile_cmd + ['-o', objects[-1], source], args )
+        compile_s += duration
+        peak_kb = max( peak_kb, peak )
+        object_bytes += os.path.getsize( objects[-1] )
+
+    objects.append( main[:-4] + '.o' )
+    main_s, main_peak_kb = measured( compile_cmd + ['-o', objects[-1], main], args )
+    object_bytes += os.path.getsize( objects[-1] )
+
+    program = os.path.join( folder, name )
+    link_s, _ = measured( [args.cxx, '-o', program] + objects + ['-pthread'], args )
+
+    if 0 != subprocess.call( [program], stdout=subprocess.DEVNULL ):
+        sys.exit( 'bench-compile.py: the suite of {} fails'.format( name ) )
+
+    return dict(
+        std=std, variant=name, header=header, definitions=' '.join( definitions ),
+        compile_s='{:.3f}'.format( compile_s ), compile_per_tu_s='{:.3f}'.format( compile_s / args.tus ),
+        peak_kb=peak_kb, main_s='{:.3f}'.format( main_s ), main_peak_kb=main_peak_kb, object_bytes=object_bytes,
+        link_s='{:.3f}'.format( link_s ), program_bytes=os.path.getsize( program ) )
+
+def appendCsv( path, rows ):
+    """Append rows to the CSV file at path, with a header line for a new file"""
+    exists = os.path.isfile( path ) and os.path.getsize( path ) > 0
+    with open( path, 'a' ) as out_file:
+        writer = csv.DictWriter( out_file, fieldnames=csv_fields, lineterminator='\n' )
+        if not exists:
+            writer.writeheader()
+        writer.writerows( rows )
+
+def selectedVariants( args ):
+    """The variants given with option --variants, all by default"""
+    if not args.variants:
+        return variants
+    names = args.variants.split( ',' )
+    unknown = [n for n in names if n not in [v[0] for v in variants]]
+    if unknown:
+        sys.exit( 'bench-compile.py: unknown variant {} (available: {})'.format( ', '.join( unknown ), ', '.join( v[0] for v in variants ) ) )
+    return [v for v in variants if v[0] in names]
+
+def benchCompile( args ):
+    folder = args.keep if args.keep else tempfile.mkdtemp( prefix='lest-bench-' )
+    if not os.path.isdir( folder ):
+        os.makedirs( folder )
+    try:
+        common = dict( lest=lestVersion(), compiler=compilerVersion( args ), flags=args.flags, tus=args.tus, cases=args.cases, assertions=args.assertions )
+
+        print( 'lest {lest}, {compiler} {flags}: {tus} test translation units of {cases} cases of {assertions} assertions'.format( **common ) )
+        print( '{:<16}{:>6}{:>10}{:>10}{:>10}{:>10}{:>10}{:>12}{:>10}'.format( 'variant', 'std', 'tests s', 'per TU s', 'peak MB', 'main s', 'main MB', 'objects kB', 'link s' ) )
+
+        rows = []
+        for variant in selectedVariants( args ):
+            row = benchVariant( variant, folder, args )
+            row.update( common )
+            rows.append( row )
+            print( '{variant:<16}{std:>6}{compile_s:>10}{compile_per_tu_s:>10}{peak:>10.0f}{main_s:>10}{main_peak:>10.0f}{objects:>12.0f}{link_s:>10}'.format(
+                peak=row['peak_kb'] / 1024.0, main_peak=row['main_peak_kb'] / 1024.0, objects=row['object_bytes'] / 1024.0, **row ) )
+
+        appendCsv( args.csv, rows )
+        print( 'Appended {} rows to {}'.format( len( rows ), args.csv ) )
+    finally:
+        if not args.keep:
+            shutil.rmtree( folder )
+
+def benchCompileFromCommandLine():
+    """Collect arguments from the commandline and run the compile-time benchmark."""
+    parser = argparse.ArgumentParser(
+        description='Compile-time benchmark of the lest headers on a synthetic test suite.',
+        epilog="""variants: """ + ', '.join( v[0] for v in variants ),
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+
+    parser.add_argument(
+        '--tus',
+        metavar='n',
+        type=int,
+        default=4,
+        help='number of test translation units')
+
+    parser.add_argument(
+        '--cases',
+        metavar='n',
+        type=int,
+        default=10,
+        help='number of test cases per translation unit')
+
+    parser.add_argument(
+        '--assertions',
+        metavar='m',
+        type=int,
+        default=8,
+        help='number of assertions per test case')
+
+    parser.add_argument(
+        '--variants',
+        metavar='list',
+        type=str,
+        default='',
+        help='comma-separated variants to build, all if empty')
+
+    parser.add_argument(
+        '--cxx',
+        metavar='compiler',
+        type=str,
+        default=os.environ.get( 'CXX', 'g++' ),
+        help='compiler')
+
+    parser.add_argument(
+        '--std',
+        metavar='s',
+        type=str,
+        default='11',
+        help='C++ standard, like 11 or 17')
+
+    parser.add_argument(
+        '--flags',
+        metavar='f',
+        type=str,
+        default='-O2',
+        help='further compiler flags')
+
+    parser.add_argument(
+        '--csv',
+        metavar='path',
+        type=str,
+        default='bench-compile.csv',
+        help='CSV file to append the results to')
+
+    parser.add_argument(
+        '--keep',
+        metavar='folder',
+        type=str,
+        default=None,
+        help='generate the suites in this folder and keep them')
+
+    parser.add_argument(
+        '-v', '--verbose',
+        action='store_true',
+        help='report the commands')
+
+    benchCompile( parser.parse_args() )
+
+if __name__ == '__main__':
+    benchCompileFromCommandLine()
+
+# end of file
@@ -0,0 +1,143 @@
+// Copyright 2013-2018 by Martin Moene
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Micro-benchmark of lest's value formatting: table-driven formatting
+// versus the previous per-byte std::ostringstream formatting, on 1 MB payloads.
+//
+// Usage: bench_lest_format [repetitions]
+
+#include "lest/lest.hpp"
+#include <cstdlib>
+
+namespace reference {
+
+// Formatting as done before the introduction of the escape and hex tables:
+
+inline std::string transformed( char chr )
+{
+    struct Tr { char chr; char const * str; } table[] =
+    {
+        {'\\', "\\\\" },
+        {'\r', "\\r"  }, {'\f', "\\f" },
+        {'\n', "\\n"  }, {'\t', "\\t" },
+    };
+
+    for ( auto tr : table )
+    {
+        if ( chr == tr.chr )
+            return tr.str;
+    }
+
+    auto unprintable = [](char c){ return 0 <= c && c < ' '; };
+
+    auto to_hex_string = [](char c)
+    {
+        std::ostringstream os;
+        os << "\\x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>( static_cast<unsigned char>(c) );
+        return os.str();
+    };
+
+    return unprintable( chr  ) ? to_hex_string( chr ) : std::string( 1, chr );
+}
+
+inline std::string make_tran_string( std::string const & txt ) { std::ostringstream os; for(auto c:txt) os << transformed(c); return os.str(); }
+
+inline std::string make_memory_string( void const * item, std::size_t size )
+{
+    // reverse order for little endian architectures:
+
+    auto is_little_endian = []
+    {
+        union U { int i = 1; char c[ sizeof(int) ]; };
+
+        return 1 != U{}.c[ sizeof(int) - 1 ];
+    };
+
+    int i = 0, end = static_cast<int>( size ), inc = 1;
+
+    if ( is_little_endian() ) { i = end - 1; end = inc = -1; }
+
+    unsigned char const * bytes = static_cast<unsigned char const *>( item );
+
+    std::ostringstream os;
+    os << "0x" << std::setfill( '0' ) << std::hex;
+    for ( ; i != end; i += inc )
+    {
+        os << std::setw(2) << static_cast<unsigned>( bytes[i] ) << " ";
+    }
+    return os.str();
+}
+
+} // namespace reference
+
+using clock_type = std::chrono::steady_clock;
+
+// keep the formatted results observable:
+
+volatile std::size_t sink = 0;
+
+template< typename F >
+double measure_ms( int repetitions, F f )
+{
+    const auto start = clock_type::now();
+    for ( int i = 0; i < repetitions; ++i )
+        sink = sink + f().size();
+    const auto stop = clock_type::now();
+
+    return std::chrono::duration<double, std::milli>( stop - start ).count() / repetitions;
+}
+
+void report( std::string const & name, double reference_ms, double table_ms )
+{
+    std::cout << std::fixed << std::setprecision( 2 )
+        << std::left  << std::setw( 24 ) << name
+        << std::right << std::setw( 12 ) << reference_ms << " ms"
+        << std::setw( 12 ) << table_ms << " ms"
+        << std::setw( 10 ) << reference_ms / table_ms << "x\n";
+}
+
+int main( int argc, char * argv[] )
+{
+    const int repetitions = argc > 1 ? std::atoi( argv[1] ) : 5;
+    const std::size_t size = 1024 * 1024;
+
+    // binary blob: every byte value; text: mostly printable with some control characters:
+
+    std::string blob( size, '\0' );
+    std::string text( size, '\0' );
+
+    for ( std::size_t i = 0; i < size; ++i )
+    {
+        blob[i] = static_cast<char>( i % 256 );
+        text[i] = i % 16 == 0 ? static_cast<char>( i % 32 ) : static_cast<char>( 'a' + i % 26 );
+    }
+
+    if ( reference::make_tran_string( blob ) != lest::make_tran_string( blob )
+      || reference::make_memory_string( blob.data(), size ) != lest::make_memory_string( blob.data(), size ) )
+    {
+        std::cerr << "bench_lest_format: table-driven formatting differs from reference\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "payload: " << size << " bytes, repetitions: " << repetitions << "\n"
+        << std::left  << std::setw( 24 ) << "format"
+        << std::right << std::setw( 15 ) << "ostringstream" << std::setw( 15 ) << "table" << std::setw( 11 ) << "speedup" << "\n";
+
+    report( "make_tran_string/blob",
+        measure_ms( repetitions, [&]{ return reference::make_tran_string( blob ); } ),
+        measure_ms( repetitions, [&]{ return     lest::make_tran_string( blob ); } ) );
+
+    report( "make_tran_string/text",
+        measure_ms( repetitions, [&]{ return reference::make_tran_string( text ); } ),
+        measure_ms( repetitions, [&]{ return     lest::make_tran_string( text ); } ) );
+
+    report( "make_memory_string",
+        measure_ms( repetitions, [&]{ return reference::make_memory_string( blob.data(), size ); } ),
+        measure_ms( repetitions, [&]{ return     lest::make_memory_string( blob.data(), size ); } ) );
+
+    return EXIT_SUCCESS;
+}
+
+// g++ -std=c++11 -O2 -Wall -I../include -o bench_lest_format bench_lest_format.cpp && bench_lest_format
@@ -0,0 +1,150 @@
+// Copyright 2013-2018 by Martin Moene
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Micro-benchmark of lest's own overhead on its hot paths: passing and failing
+// assertions, conversion to text, test selection and re-entry of sections.
+// Build it with and without lest_FEATURE_REGEX_SEARCH to compare selection.
+//
+// Output is CSV, one line per benchmark, to compare runs of a build with
+// those of another build:
+//
+//   benchmark,regex_search,iterations,ns_per_op
+//
+// Usage: bench_lest_runtime [scale]
+
+#include "lest/lest.hpp"
+#include <cstdlib>
+
+using clock_type = std::chrono::steady_clock;
+
+// keep the results observable:
+
+volatile std::size_t sink = 0;
+
+// duration in ns of one call of f, over iterations calls, after a warm-up:
+
+template< typename F >
+double measure_ns( long iterations, F f )
+{
+    for ( long i = 0; i < iterations / 10 + 1; ++i )
+        f();
+
+    const auto start = clock_type::now();
+    for ( long i = 0; i < iterations; ++i )
+        f();
+    const auto stop = clock_type::now();
+
+    return std::chrono::duration<double, std::nano>( stop - start ).count() / static_cast<double>( iterations );
+}
+
+void report( std::string const & name, long iterations, double ns_per_op )
+{
+    std::cout << name << "," << lest_FEATURE_REGEX_SEARCH << "," << iterations << ","
+        << std::fixed << std::setprecision( 1 ) << ns_per_op << "\n";
+}
+
+template< typename F >
+void bench( std::string const & name, long iterations, F f )
+{
+    report( name, iterations, measure_ns( iterations, f ) );
+}
+
+int main( int argc, char * argv[] )
+{
+    const long scale = argc > 1 ? std::atol( argv[1] ) : 1;
+
+    std::ostream discard( nullptr );
+    lest::env lest_env( discard, lest::options() );
+    lest_env( "bench" );
+
+    const int         i = 42;
+    const std::string s = "hello, world";
+    const std::vector<int> v{ 1, 2, 3, 4, 5, 6, 7, 8 };
+
+    std::cout << "benchmark,regex_search,iterations,ns_per_op\n";
+
+    // passing assertions: decomposition, comparison and the (unused) decomposition text:
+
+    bench( "expect_pass_int"      , scale * 1000000, [&]{ EXPECT( i == 42 ); } );
+    bench( "expect_pass_string"   , scale *  500000, [&]{ EXPECT( s == "hello, world" ); } );
+    bench( "expect_pass_container", scale *  200000, [&]{ EXPECT( v == v ); } );
+
+    // failing assertion: decomposition text, failure construction, throw and catch:
+
+    bench( "expect_fail_int", scale * 50000, [&]
+    {
+        try { EXPECT( i == 7 ); } catch ( lest::message const & e ) { sink = sink + e.note.info.size(); }
+    } );
+
+    bench( "expect_fail_string", scale * 50000, [&]
+    {
+        try { EXPECT( s == "bye" ); } catch ( lest::message const & e ) { sink = sink + e.note.info.size(); }
+    } );
+
+    // conversion to text of common types:
+
+    bench( "to_string_int"      , scale * 1000000, [&]{ sink = sink + lest::to_string( i    ).size(); } );
+    bench( "to_string_double"   , scale *  500000, [&]{ sink = sink + lest::to_string( 3.14 ).size(); } );
+    bench( "to_string_string"   , scale * 1000000, [&]{ sink = sink + lest::to_string( s    ).size(); } );
+    bench( "to_string_char_ptr" , scale * 1000000, [&]{ sink = sink + lest::to_string( "hello" ).size(); } );
+    bench( "to_string_container", scale *  200000, [&]{ sink = sink + lest::to_string( v    ).size(); } );
+
+    // selection of tests by name, per name of 100k names:
+
+    lest::texts names;
+    for ( int k = 0; k < 100000; ++k )
+        names.push_back( "suite " + lest::to_string( k % 100 ) + ": case " + lest::to_string( k ) + ( k % 10 ? " [fast]" : " [slow]" ) );
+
+    auto select_all = [&]( lest::texts const & include )
+    {
+        return [&names, include]
+        {
+            std::size_t selected = 0;
+            for ( auto const & name : names )
+                selected += lest::select( name, include );
+            sink = sink + selected;
+        };
+    };
+
+    const long names_count = static_cast<long>( names.size() );
+
+    report( "select_none"   , scale * names_count, measure_ns( scale, select_all( {} ) ) / static_cast<double>( names_count ) );
+    report( "select_include", scale * names_count, measure_ns( scale, select_all( { "case 4242" } ) ) / static_cast<double>( names_count ) );
+    report( "select_omit"   , scale * names_count, measure_ns( scale, select_all( { "suite 1", "!fast" } ) ) / static_cast<double>( names_count ) );
+
+    // re-entry of sections: a test runs its body once for each section:
+
+    const lest::test sections[] =
+    {
+        CASE( "sections" )
+        {
+            SETUP( "context" )
+            {
+                int n = 0;
+
+                SECTION( "1" ) { n += 1; }
+                SECTION( "2" ) { n += 2; }
+                SECTION( "3" ) { n += 3; }
+                SECTION( "4" ) { n += 4; }
+                SECTION( "5" ) { n += 5; }
+                SECTION( "6" ) { n += 6; }
+                SECTION( "7" ) { n += 7; }
+                SECTION( "8" ) { n += 8; }
+
+                sink = sink + static_cast<std::size_t>( n );
+            }
+        },
+    };
+
+    report( "section_reentry", scale * 800000, measure_ns( scale * 100000, [&]
+    {
+        sections[0].behaviour( lest_env( sections[0].name ) );
+    } ) / 8 );
+
+    return EXIT_SUCCESS;
+}
+
+// g++ -std=c++11 -O2 -Wall -I../include -o bench_lest_runtime bench_lest_runtime.cpp && bench_lest_runtime
+// g++ -std=c++11 -O2 -Wall -Dlest_FEATURE_REGEX_SEARCH=1 -I../include -o bench_lest_runtime_regex bench_lest_runtime.cpp && bench_lest_runtime_regex
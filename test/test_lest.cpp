@@ -12,7 +12,21 @@
 # pragma GCC   diagnostic ignored "-Wfloat-equal"
 #endif
 
+// Test fuzz and data cases, and the options that start processes:
+
+#define lest_FEATURE_FUZZ     1
+#define lest_FEATURE_DATA     1
+#define lest_FEATURE_PROCESS  1
+
+// A to_string() in namespace lest for a type elsewhere, declared before lest:
+
+#include <string>
+
+namespace legacy { struct stringed { int value; }; }
+namespace lest   { std::string to_string( legacy::stringed const & x ); }
+
 #include "lest/lest.hpp"
+#include <array>
 #include <set>
 
 // Suppress:
@@ -47,6 +61,20 @@ using namespace lest;
 
 struct S { void f(){} };
 
+namespace udt {
+
+struct formatted { int value; };
+struct stringed  { int value; };
+struct streamed  { int value; };
+
+void format_to( lest::appender & out, formatted const & x ) { out.append( "formatted:" ); lest::format_to( out, x.value ); }
+std::string to_string( stringed const & x ) { return "stringed:" + lest::to_string( x.value ); }
+std::ostream & operator<<( std::ostream & os, streamed const & x ) { return os << "streamed:" << x.value; }
+
+} // namespace udt
+
+std::string lest::to_string( legacy::stringed const & x ) { return "legacy:" + lest::to_string( x.value ); }
+
 const lest::test specification[] =
 {
     CASE( "Function to suppress warning \"expression has no effect\" acts as identity function" )
@@ -391,6 +419,116 @@ const lest::test specification[] =
         EXPECT( 0 == run( pass, os ) );
     },
 
+    CASE( "Expect on a thread of the test records failures that fail the test when it returns" )
+    {
+        int after = 0;
+
+        test pass[] = {{ CASE( "P" )
+        {
+            std::thread worker( [&]() { for ( int i = 0; i < 100; ++i ) { EXPECT( i < 100 ); } } );
+            worker.join();
+        } }};
+
+        test fail[] = {{ CASE_ON( "F", &after )
+        {
+            std::thread worker( [&]()
+            {
+                for ( int i = 0; i < 100; ++i ) { EXPECT( i < 98 ); }
+                EXPECT_THROWS( true );
+            } );
+            worker.join();
+            ++after;
+        } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, os ) );
+        EXPECT( 1 == run( fail, os ) );
+        EXPECT( after == 1 );
+        EXPECT( os.str().find( "failed: F: i < 98 for 98 < 98" ) != text::npos );
+        EXPECT( os.str().find( "failed: F: i < 98 for 99 < 98" ) != text::npos );
+        EXPECT( os.str().find( "failed: didn't get exception: F: true" ) != text::npos );
+    },
+
+    CASE( "Expect on threads of the test reports passes while the test's thread enters sections" )
+    {
+        test pass[] = {{ CASE( "P" )
+        {
+            std::vector<std::thread> workers;
+
+            for ( int t = 0; t < 3; ++t )
+                workers.emplace_back( [&]() { for ( int i = 0; i < 200; ++i ) { EXPECT( i < 200 ); } } );
+
+            SETUP( "Context" ) {
+                SECTION( "A" ) { EXPECT( true ); }
+                SECTION( "B" ) { EXPECT( true ); }
+            }
+
+            for ( auto & worker : workers )
+                worker.join();
+        } }};
+
+        for ( auto const & options : { texts{ "--pass", "--verbose" }, texts{ "--pass", "--verbose", "--async-report" } } )
+        {
+            std::ostringstream os;
+
+            EXPECT( 0 == run( pass, options, os ) );
+
+            int passes = 0;
+            for ( auto pos = os.str().find( "passed: P" ); pos != text::npos; pos = os.str().find( "passed: P", pos + 1 ) )
+                ++passes;
+
+            EXPECT( passes == 602 );
+            EXPECT( os.str().find( "passed: P\n  Context\n  A: true" ) != text::npos );
+        }
+    },
+
+    CASE( "Stress runs the code on each thread for each iteration and reports per-thread failures" )
+    {
+        std::atomic<int> runs( 0 );
+
+        test pass[] = {{ CASE_ON( "P", &runs )
+        {
+            STRESS( 4, 250 ) { ++runs; EXPECT( iteration < 250 ); };
+        } }};
+
+        test fail[] = {{ CASE( "F" )
+        {
+            STRESS( 3, 10 ) { EXPECT( thread * iteration < 5 ); };
+        } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--pass", "--pin-threads" }, os ) );
+        EXPECT( runs == 1000 );
+        EXPECT( os.str().find( ": stress: P: STRESS( 4, 250 ): 1000 ops in " ) != text::npos );
+        EXPECT( os.str().find( " ops/s, imbalance " ) != text::npos );
+        EXPECT( os.str().find( "% (fastest thread " ) != text::npos );
+        EXPECT( os.str().find( "\n  thread 0: 250 ops in " ) != text::npos );
+        EXPECT( os.str().find( "\n  thread 3: 250 ops in " ) != text::npos );
+
+        EXPECT( 1 == run( fail, os ) );
+        EXPECT( os.str().find( "failed (thread 1, iteration 5): F: thread * iteration < 5 for 5 < 5" ) != text::npos );
+        EXPECT( os.str().find( "failed (thread 2, iteration 3): F: thread * iteration < 5 for 6 < 5" ) != text::npos );
+        EXPECT( os.str().find( "failed: stress (2 out of 3 threads failed): F: STRESS( 3, 10 )" ) != text::npos );
+    },
+
+    CASE( "Stress fails for fewer than 1 thread or 0 iterations" )
+    {
+        int none = 0, negative = -1;
+
+        test fail[] = {
+            { CASE_ON( "T", none     ) { STRESS( none, 10 ) {}; } },
+            { CASE_ON( "I", negative ) { STRESS( 2, negative ) {}; } },
+        };
+
+        std::ostringstream os;
+
+        EXPECT( 2 == run( fail, os ) );
+        EXPECT( os.str().find( "failed: stress (requires at least 1 thread and 0 iterations): T: STRESS( none, 10 )" ) != text::npos );
+        EXPECT( os.str().find( "failed: stress (requires at least 1 thread and 0 iterations): I: STRESS( 2, negative )" ) != text::npos );
+    },
+
     CASE( "Setup creates a fresh fixture for each section" )
     {
         SETUP("Context") {
@@ -414,6 +552,179 @@ const lest::test specification[] =
         EXPECT( i == 2 );
     },
 
+    CASE( "Shared setup makes its state once and gives each section a fresh copy" )
+    {
+        int made = 0;
+        auto make = [&made]() { ++made; return std::vector<int>{ 1, 2, 3 }; };
+
+        SETUP_SHARED( "Context", numbers, make ) {
+            EXPECT( numbers.size() == 3u );
+
+            SECTION("S1") { numbers.clear(); }
+            SECTION("S2") { numbers.push_back( 4 ); EXPECT( numbers.size() == 4u ); }
+            SECTION("S3") { EXPECT( numbers.size() == 3u ); }
+        }
+        EXPECT( made == 1 );
+    },
+
+    CASE( "Shared given gives each section a fresh copy of the state it names" )
+    {
+        int made = 0;
+        auto make = [&made]() { ++made; return std::string( "abc" ); };
+
+        GIVEN_SHARED( "Text", word, make ) {
+            SECTION("S1") { word += "d"; EXPECT( word == "abcd" ); }
+            SECTION("S2") { EXPECT( word == "abc" ); }
+        }
+        EXPECT( made == 1 );
+    },
+
+    CASE( "Suite fixture is made on first use and torn down after its last selected user" )
+    {
+        int made = 0;
+        std::vector<int> seen;
+        lest::fixture< std::vector<int> > data( "data", [&made]() { ++made; return std::vector<int>( 3, 7 ); } );
+
+        test users[] = {
+            { CASE_ON( "A [data]", &data, &seen ) { seen.push_back( static_cast<int>( data().size() ) ); } },
+            { CASE_ON( "B [data]", &data, &seen ) { seen.push_back( data.built() ); data(); } },
+            { CASE_ON( "C"       , &data, &seen ) { seen.push_back( data.built() ); } },
+        };
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( users, { }, os ) );
+        EXPECT( made == 1 );
+        EXPECT( seen == ( std::vector<int>{ 3, 1, 0 } ) );
+        EXPECT( !data.built() );
+    },
+
+    CASE( "Option --time reports the setup of suite fixtures apart from test time [commandline]" )
+    {
+        lest::fixture<int> answer( "answer", []() { return 42; } );
+
+        test users[] = {{ CASE_ON( "A [answer]", &answer ) { EXPECT( answer() == 42 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( users, { "--time" }, os ) );
+        EXPECT( os.str().find( " ms: fixture answer (setup)\n" ) != text::npos );
+        EXPECT( os.str().find( " ms: fixture answer (teardown)\n" ) != text::npos );
+        EXPECT( os.str().find( " ms: A [answer]\n" ) != text::npos );
+    },
+
+    CASE( "Option --section=path runs only the enclosing code and the sections along path [commandline]" )
+    {
+        int setups = 0;
+        text ran;
+
+        test sections[] = {{ CASE_ON( "T", &setups, &ran )
+        {
+            SETUP( "Context" ) {
+                ++setups;
+
+                SECTION( "Alpha" ) {
+                    ran += "A";
+
+                    SECTION( "One" ) { ran += "1"; }
+                    SECTION( "Two" ) { ran += "2"; }
+                }
+                SECTION( "Beta" ) { ran += "B"; }
+            }
+        } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( sections, { "--section=alpha/two" }, os ) );
+        EXPECT( setups == 1 );
+        EXPECT( ran == "A2" );
+
+        setups = 0; ran.clear();
+
+        EXPECT( 0 == run( sections, { }, os ) );
+        EXPECT( setups == 2 );
+        EXPECT( ran == "A1A2B" );
+    },
+
+    CASE( "Option --list-sections lists the section tree of selected tests [commandline]" )
+    {
+        test sections[] = {{ CASE( "T" )
+        {
+            SETUP( "Context" ) {
+                SECTION( "Alpha" ) {
+                    SECTION( "One" ) { }
+                    SECTION( "Two" ) { EXPECT( false ); }
+                }
+                SECTION( "Beta" ) { }
+            }
+        } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( sections, { "--list-sections" }, os ) );
+        EXPECT( os.str() == "T\n  Alpha\n    One\n    Two\n  Beta\n" );
+    },
+
+    CASE( "Option --section-jobs=n runs the section paths of a test on n threads [commandline]" )
+    {
+        std::atomic<int> one( 0 ), two( 0 ), beta( 0 );
+
+        test sections[] = {{ CASE_ON( "T", &one, &two, &beta )
+        {
+            SETUP( "Context" ) {
+                SECTION( "Alpha" ) {
+                    SECTION( "One" ) { ++one; }
+                    SECTION( "Two" ) { ++two; EXPECT( 1 == 2 ); }
+                }
+                SECTION( "Beta" ) { ++beta; EXPECT( 2 == 3 ); }
+            }
+        } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( sections, { "--section-jobs=3" }, os ) );
+        EXPECT( one == 1 );
+        EXPECT( two == 1 );
+        EXPECT( beta == 1 );
+
+        EXPECT( std::string::npos != os.str().find( "1 out of 1 selected test failed." ) );
+        EXPECT( os.str().find( "1 == 2" ) < os.str().find( "2 == 3" ) );
+        EXPECT( os.str().find( "2 == 3" ) < os.str().find( "1 out of 1" ) );
+    },
+
+    CASE( "Option --section-jobs=n runs a test on the runner's thread until it finds sections [commandline]" )
+    {
+        int runs = 0;
+        std::thread::id ran;
+
+        test plain[] = {{ CASE_ON( "P", &runs, &ran ) { ++runs; ran = std::this_thread::get_id(); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( plain, { "--section-jobs=3" }, os ) );
+        EXPECT( runs == 1 );
+        EXPECT( ran == std::this_thread::get_id() );
+    },
+
+    CASE( "Option --jobs=n doesn't run sections in parallel [commandline]" )
+    {
+        std::set<std::thread::id> ran;
+
+        test sections[] = {{ CASE_ON( "T", &ran )
+        {
+            SETUP( "Context" ) {
+                SECTION( "Alpha" ) { ran.insert( std::this_thread::get_id() ); }
+                SECTION( "Beta"  ) { ran.insert( std::this_thread::get_id() ); }
+            }
+        } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( sections, { "--jobs=3" }, os ) );
+        EXPECT( ran.size() == 1u );
+        EXPECT( *ran.begin() == std::this_thread::get_id() );
+    },
+
     CASE( "Decomposition supports explicit operator bool()" )
     {
         struct Nonexplicit { operator bool() const { return true; } };
@@ -505,6 +816,24 @@ const lest::test specification[] =
         EXPECT( std::string::npos != os.str().find( "'\\x8' > '\\t' for '\\x08' > '\\t'" ) );
     },
 
+    CASE( "Decomposition escapes every unprintable character of a string" )
+    {
+        std::string txt( "a\\\r\f\n\t\x01\x1f b\x7f" );
+        txt += '\0';
+
+        EXPECT( "a\\\\\\r\\f\\n\\t\\x01\\x1f b\x7f\\x00" == make_tran_string( txt ) );
+        EXPECT( "" == make_tran_string( "" ) );
+        EXPECT( "\\x1b" == transformed( '\x1b' ) );
+    },
+
+    CASE( "Decomposition formats memory as hex bytes" )
+    {
+        unsigned char bytes[] = { 0x00, 0x7f, 0x80, 0xff };
+
+        EXPECT( "0xff 80 7f 00 " == make_memory_string( bytes, sizeof bytes ) );
+        EXPECT( "0x" == make_memory_string( bytes, 0 ) );
+    },
+
     CASE( "Decomposition formats std::string with double quotes" )
     {
         std::string hello( "hello" );
@@ -537,6 +866,17 @@ const lest::test specification[] =
         EXPECT( std::string::npos != os.str().find( "world < std_hello for \"world\" < \"hello\"" ) );
     },
 
+    CASE( "Decomposition formats numbers, floating point values in shortest round-trip form if available" )
+    {
+        EXPECT( "-42" == lest::make_number_string( -42 ) );
+        EXPECT( "18446744073709551615" == lest::make_number_string( std::numeric_limits<unsigned long long>::max() ) );
+        EXPECT( "0.1" == lest::make_number_string( 0.1  ) );
+        EXPECT( "0.1" == lest::make_number_string( 0.1f ) );
+#if lest_HAVE_TO_CHARS
+        EXPECT( "0.30000000000000004" == lest::make_number_string( 0.1 + 0.2 ) );
+#endif
+    },
+
     CASE( "Decomposition formats an enum as its underlying value" )
     {
         enum { a, b, c, };
@@ -572,6 +912,17 @@ const lest::test specification[] =
         EXPECT( "{ 'a', 42, 3.14, \"hello world\" }" == lest::to_string( std::make_tuple( 'a', 42, 3.14, "hello world" ) ) );
     },
 
+    CASE( "Decomposition formats a user-defined type via format_to(), to_string() or operator<<()" )
+    {
+        std::vector<udt::formatted> v{ { 1 }, { 2 } };
+
+        EXPECT( "formatted:7" == lest::to_string( udt::formatted{ 7 } ) );
+        EXPECT( "{ formatted:1, formatted:2, }" == lest::to_string( v ) );
+        EXPECT( "{ stringed:3, streamed:4 }" == lest::to_string( std::make_pair( udt::stringed{ 3 }, udt::streamed{ 4 } ) ) );
+        EXPECT( "{ stringed:5, }" == lest::to_string( std::vector<udt::stringed>{ { 5 } } ) );
+        EXPECT( "{ legacy:6, }" == lest::to_string( std::vector<legacy::stringed>{ { 6 } } ) );
+    },
+
     CASE( "Decomposition formats container with curly braces" )
     {
         std::set<int> s{ 1, 2, 3, };
@@ -589,6 +940,99 @@ const lest::test specification[] =
         EXPECT( std::string::npos != os.str().find( "{ 0, 1, 2, }" ) );
     },
 
+    CASE( "Decomposition reports differences of large containers instead of all elements" )
+    {
+        std::vector<int> a( 100000, 7 );
+        std::vector<int> b( a );
+        b[17] = 8; b[18] = 9; b[90000] = 1;
+
+        const std::string decomposition = lest::to_string( a, "==", b );
+
+        EXPECT( decomposition.size() < 300u );
+        EXPECT( std::string::npos != decomposition.find( "{ size: 100000 } == { size: 100000 }: 3 differences; at [17] [18] [90000]" ) );
+        EXPECT( std::string::npos != decomposition.find( "[15..20]: { 7, 7, 7, 7, 7, 7, } vs { 7, 7, 8, 9, 7, 7, }" ) );
+        EXPECT( std::string::npos != decomposition.find( "[89998..90002]: { 7, 7, 7, 7, 7, } vs { 7, 7, 1, 7, 7, }" ) );
+    },
+
+    CASE( "Decomposition reports size difference of large containers" )
+    {
+        std::vector<int> a( 100, 7 );
+        std::vector<int> b( 101, 7 );
+
+        const std::string decomposition = lest::to_string( a, "==", b );
+
+        EXPECT( std::string::npos != decomposition.find( "{ size: 100 } == { size: 101 }: 0 differences in 100 common elements, sizes differ; at [100]" ) );
+        EXPECT( std::string::npos != decomposition.find( "[98..100]: { 7, 7, } vs { 7, 7, 7, }" ) );
+
+        EXPECT( "{ size: 100 } == { size: 100 }" == lest::to_string( a, "==", a ) );
+    },
+
+    CASE( "Decomposition limits the number of reported differences of large containers" )
+    {
+        std::vector<int> a( 1000, 7 );
+        std::vector<int> b( 1000, 8 );
+
+        const std::string decomposition = lest::to_string( a, "==", b );
+
+        EXPECT( std::string::npos != decomposition.find( "1000 differences; at [0] [1] [2] [3] [4] ...; [0..6]" ) );
+        EXPECT( decomposition.size() <= std::size_t( lest_FEATURE_DIFF_MAX_OUTPUT + 3 ) );
+    },
+
+    CASE( "Expect_range_eq succeeds for equal contiguous ranges" )
+    {
+        std::vector<int> v( 1000, 7 );
+        std::vector<int> w( v );
+        int a[] = { 1, 2, 3 };
+        int b[] = { 1, 2, 3 };
+        std::array<double, 3> x = {{ 1.0, 2.0, 3.0 }};
+        std::vector<double> y = { 1.0, 2.0, 3.0 };
+
+        EXPECT_RANGE_EQ( v, w );
+        EXPECT_RANGE_EQ( a, b );
+        EXPECT_RANGE_EQ( x, y );
+        EXPECT_RANGE_EQ( std::string( "hello" ), std::string( "hello" ) );
+    },
+
+    CASE( "Expect_range_eq reports first mismatch, count and neighbouring elements" )
+    {
+        test fail[] = {{ CASE( "F" )
+        {
+            std::vector<short> v( 100000, 7 );
+            std::vector<short> w( v );
+            w[4321] = 8; w[50000] = 9;
+
+            EXPECT_RANGE_EQ( v, w );
+        } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "range_eq( v, w ) for { size: 100000 } == { size: 100000 }: 2 differences; first at [4321]" ) );
+        EXPECT( std::string::npos != os.str().find( "[4319..4323]: { 7, 7, 7, 7, 7, } vs { 7, 7, 8, 7, 7, }" ) );
+        EXPECT( os.str().size() < 500u );
+    },
+
+    CASE( "Expect_range_eq finds mismatch at every position and reports size difference" )
+    {
+        for ( std::size_t n : { 1u, 15u, 16u, 17u, 31u, 32u, 33u, 100u } )
+        {
+            std::vector<char> v( n, 'a' );
+
+            for ( std::size_t i = 0; i < n; ++i )
+            {
+                std::vector<char> w( v ); w[i] = 'b';
+
+                lest::result outcome = range_eq( v, w );
+
+                EXPECT_NOT( outcome.passed );
+                EXPECT( std::string::npos != outcome.decomposition.find( "first at [" + to_string( static_cast<unsigned>( i ) ) + "]" ) );
+            }
+        }
+
+        EXPECT( std::string::npos != range_eq( std::vector<int>( 3 ), std::vector<int>( 4 ) ).decomposition.find( "sizes differ" ) );
+    },
+
     CASE( "Has single expression evaluation" )
     {
         test pass[] = {{ CASE( "P" ) { int n = 0; EXPECT( 1 == ++n ); } }};
@@ -637,6 +1081,103 @@ const lest::test specification[] =
         EXPECT( divide( 22, 7 ) != approx( 3.141 ).epsilon( 0.0001 ) );
     },
 
+    CASE( "Approximate using ulps compares properly" )
+    {
+        const double one_up   = std::nextafter( 1.0, 2.0 );
+        const double two_up   = std::nextafter( one_up, 2.0 );
+        const double tiny     = std::nextafter( 0.0, 1.0 );
+        const float  float_up = std::nextafter( 1.0f, 2.0f );
+
+        EXPECT(     one_up == approx( 1.0 ).ulps( 1 ) );
+        EXPECT(     two_up != approx( 1.0 ).ulps( 1 ) );
+        EXPECT(       -0.0 == approx( 0.0 ).ulps( 1 ) );
+        EXPECT(       tiny == approx( -tiny ).ulps( 2 ) );
+        EXPECT(   float_up == approx( 1.0f ).ulps( 1 ) );
+        EXPECT( approx( 1e300 ).ulps( 1000 ) != std::numeric_limits<double>::quiet_NaN() );
+
+        EXPECT( std::string::npos != to_string( two_up, "==", approx( 1.0 ).ulps( 1 ) ).find( "(ulp distance: 2, max: 1)" ) );
+        EXPECT( std::string::npos == to_string( two_up, "==", approx( 1.0 ) ).find( "ulp" ) );
+    },
+
+    CASE( "Approximate takes a magnitude of any type that converts to double" )
+    {
+        struct meters { double value; operator double() const { return value; } };
+
+        const float float_up = std::nextafter( 1.0f, 2.0f );
+
+        EXPECT( 1.5 == approx( meters{ 1.5 } ) );
+        EXPECT( 2.0 == approx( 2 ) );
+        EXPECT( float_up == approx::custom().ulps( 1 )( 1.0f ) );
+        EXPECT( float_up != approx::custom().ulps( 1 )( 1.0  ) );
+    },
+
+    CASE( "Approximate array comparison succeeds for close values" )
+    {
+        std::vector<double> a( 10000, 1.0 );
+        std::vector<double> b( 10000, 1.0 + 1e-9 );
+        std::vector<float>  c( 10000, 1.0f );
+        float d[] = { 1.0f, 2.0f, std::numeric_limits<float>::infinity() };
+        float e[] = { 1.0f, 2.0f, std::numeric_limits<float>::infinity() };
+
+        EXPECT_ALL_APPROX( a, b, approx::custom() );
+        EXPECT_ALL_APPROX( c, a, approx::custom() );
+        EXPECT_ALL_APPROX( d, e, approx::custom() );
+        EXPECT_ALL_APPROX( a, std::vector<double>( 10000, 1.1 ), approx::custom().epsilon( 0.1 ) );
+    },
+
+    CASE( "Approximate array comparison reports violations, errors and worst element" )
+    {
+        std::vector<double> a( 10000, 1.0 );
+        std::vector<double> b( a );
+        b[7] = 1.5; b[42] = 3.0; b[99] = std::numeric_limits<double>::quiet_NaN(); b[100] = std::numeric_limits<double>::infinity();
+
+        lest::result outcome = all_approx( a, b, approx::custom() );
+
+        EXPECT_NOT( outcome.passed );
+        EXPECT( std::string::npos != outcome.decomposition.find( "{ size: 10000 } == approx { size: 10000 }: 4 violations (NaN: 1, Inf: 1)" ) );
+        EXPECT( std::string::npos != outcome.decomposition.find( "max abs error: inf" ) );
+        EXPECT( std::string::npos != outcome.decomposition.find( "worst at [100]: 1 vs inf" ) );
+
+        b[99] = b[100] = 1.0;
+
+        EXPECT( std::string::npos != all_approx( a, b, approx::custom() ).decomposition.find( "2 violations (NaN: 0, Inf: 0); max abs error: 2, max rel error: 0.666667; worst at [42]: 1 vs 3" ) );
+
+        EXPECT( std::string::npos != all_approx( a, std::vector<double>( 3 ), approx::custom() ).decomposition.find( "sizes differ" ) );
+    },
+
+    CASE( "Approximate array comparison of floats agrees with scalar approx at the tolerance" )
+    {
+        // 1.20000064f and 1.0000006f are close in double, not in float:
+
+        std::vector<float> a( 100, 1.20000064f );
+        std::vector<float> b( 100, 1.0000006f );
+
+        EXPECT( a[0] == approx( b[0] ).epsilon( 0.1 ) );
+        EXPECT( all_approx( a, b, approx::custom().epsilon( 0.1 ) ).passed );
+
+        b[50] = 1.0f;
+
+        EXPECT( a[50] != approx( b[50] ).epsilon( 0.1 ) );
+        EXPECT( std::string::npos != all_approx( a, b, approx::custom().epsilon( 0.1 ) ).decomposition.find( ": 1 violation (NaN: 0, Inf: 0)" ) );
+    },
+
+    CASE( "Approximate array comparison using ulps reports ulp distance" )
+    {
+        std::vector<float> a( 1000, 1.0f );
+        std::vector<float> b( a );
+        b[5] = std::nextafter( 1.0f, 2.0f );
+
+        EXPECT_ALL_APPROX( a, b, approx::custom().ulps( 1 ) );
+
+        b[9] = std::nextafter( std::nextafter( 1.0f, 0.0f ), 0.0f );
+
+        lest::result outcome = all_approx( a, b, approx::custom().ulps( 1 ) );
+
+        EXPECT_NOT( outcome.passed );
+        EXPECT( std::string::npos != outcome.decomposition.find( "1 violation (NaN: 0, Inf: 0)" ) );
+        EXPECT( std::string::npos != outcome.decomposition.find( "max ulp distance: 2 (max: 1); worst at [9]" ) );
+    },
+
     CASE( "Skips tests tagged [hide]" )
     {
         EXPECT( false );
@@ -957,6 +1498,282 @@ const lest::test specification[] =
         }
     },
 
+    CASE( "Option --async-report reports passing and failing tests in order [commandline]" )
+    {
+        test pass[] = {{ CASE( "a b c" ) { EXPECT( 1 == 1 ); EXPECT_NOT( 1 == 2 ); EXPECT_NO_THROW( true ); EXPECT_THROWS_AS( throw 7, int ); } }};
+        test fail[] = {{ CASE( "P" ) { EXPECT( 1 == 1 ); } },
+                       { CASE( "F" ) { EXPECT( 1 == 2 ); } }};
+        {
+            std::ostringstream os;
+
+            EXPECT( 0 == run( pass, { "--pass", "--async-report" }, os ) );
+
+            EXPECT( std::string::npos != os.str().find( "passed: a b c: 1 == 1 for 1 == 1" ) );
+            EXPECT( std::string::npos != os.str().find( "passed: a b c: ! ( 1 == 2 ) for ! ( 1 == 2 )" ) );
+            EXPECT( std::string::npos != os.str().find( "passed: got no exception: a b c: true" ) );
+            EXPECT( std::string::npos != os.str().find( "passed: got exception of type int: a b c: throw 7" ) );
+            EXPECT( std::string::npos != os.str().find( "All 1 selected test passed." ) );
+        }
+        {
+            std::ostringstream os;
+
+            EXPECT( 1 == run( fail, { "--pass", "--async-report" }, os ) );
+
+            EXPECT( os.str().find( "passed: P" ) < os.str().find( "failed: F" ) );
+            EXPECT( os.str().find( "failed: F" ) < os.str().find( "1 out of 2" ) );
+        }
+        {
+            std::ostringstream sync;
+            std::ostringstream async;
+
+            EXPECT( 1 == run( fail, { "--pass" }, sync ) );
+            EXPECT( 1 == run( fail, { "--pass", "--async-report" }, async ) );
+
+            EXPECT( sync.str() == async.str() );
+        }
+        {
+            std::ostringstream os;
+
+            EXPECT( 0 == run( pass, { "--time", "--async-report" }, os ) );
+
+            EXPECT( os.str().find( "ms: a b c" ) < os.str().find( "Elapsed" ) );
+        }
+    },
+
+    CASE( "Bounded queue delivers pushed items in order and reports full" )
+    {
+        bounded_queue<int> queue( 4 );
+
+        for ( int i = 0; i < 4; ++i )
+            EXPECT( queue.try_push( int( i ) ) );
+
+        EXPECT_NOT( queue.try_push( 4 ) );
+
+        int value = -1;
+        for ( int i = 0; i < 4; ++i )
+        {
+            EXPECT( queue.try_pop( value ) );
+            EXPECT( value == i );
+        }
+        EXPECT_NOT( queue.try_pop( value ) );
+    },
+
+    CASE( "Property holds for all generated values [property]" )
+    {
+        test pass[] = {{ PROPERTY( "P", gen::vector( gen::int_( 0, 100 ) ) )
+        {
+            int sum = 0; for ( auto x : value ) sum += x;
+            EXPECT( sum >= 0 );
+        } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--pass", "--property-cases=1000" }, os ) );
+        EXPECT( std::string::npos != os.str().find( "passed: P: property for 1000 cases, seed 0" ) );
+    },
+
+    CASE( "Property reports seed and shrunk counterexample on failure [property]" )
+    {
+        test fail[] = {{ PROPERTY( "F", gen::vector( gen::int_( 0, 100 ) ) )
+        {
+            int sum = 0; for ( auto x : value ) sum += x;
+            EXPECT( sum < 10 );
+        } }};
+
+        std::ostringstream os1;
+        std::ostringstream os2;
+
+        EXPECT( 1 == run( fail, { "--random-seed=7" }, os1 ) );
+        EXPECT( 1 == run( fail, { "--random-seed=7" }, os2 ) );
+
+        EXPECT( os1.str() == os2.str() );
+        EXPECT( std::string::npos != os1.str().find( "failed: property falsified (seed 7, case 2, 3 shrinks): F: sum < 10 for 10 < 10; counterexample: { 10, }" ) );
+    },
+
+    CASE( "Property is falsified by any exception, also while shrinking [property]" )
+    {
+        test std_[] = {{ PROPERTY( "S", gen::int_( 0, 100 ) ) { if ( value > 90 ) throw std::runtime_error( "too big" ); } }};
+        test int_[] = {{ PROPERTY( "I", gen::int_( 0, 100 ) ) { if ( value > 90 ) throw value; } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( std_, { "--random-seed=7" }, os ) );
+        EXPECT( 1 == run( int_, { "--random-seed=7" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: property falsified (seed 7, case " ) );
+        EXPECT( std::string::npos != os.str().find( "S: unexpected exception with message \"too big\"; counterexample: 91" ) );
+        EXPECT( std::string::npos != os.str().find( "I: unexpected exception of unknown type; counterexample: 91" ) );
+    },
+
+    CASE( "Option --property-cases=0 is recognised as invalid [commandline][property]" )
+    {
+        std::ostringstream os;
+
+        EXPECT( 1 == run( { }, { "--property-cases=0" }, os ) );
+    },
+
+    CASE( "Option --jobs=n finds the same counterexample as a single thread [commandline][property]" )
+    {
+        test fail[] = {{ PROPERTY( "F", gen::vector( gen::int_( 0, 100 ) ) )
+        {
+            int sum = 0; for ( auto x : value ) sum += x;
+            EXPECT( sum < 50 );
+        } }};
+        test pass[] = {{ PROPERTY( "P", gen::int_() ) { EXPECT( value == value ); } }};
+        test none[] = {{ PROPERTY( "E", gen::int_( 0, 100 ) ) { if ( value > 90 ) throw std::runtime_error( "unexpected" ); } }};
+
+        std::ostringstream os1;
+        std::ostringstream os4;
+
+        EXPECT( 1 == run( fail, { "--property-cases=1000" }, os1 ) );
+        EXPECT( 1 == run( fail, { "--property-cases=1000", "--jobs=4" }, os4 ) );
+        EXPECT( os1.str() == os4.str() );
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--pass", "--property-cases=1000", "--jobs=3" }, os ) );
+        EXPECT( std::string::npos != os.str().find( "property for 1000 cases" ) );
+
+        std::ostringstream one;
+        std::ostringstream two;
+
+        EXPECT( 1 == run( none, { }, one ) );
+        EXPECT( 1 == run( none, { "--jobs=2" }, two ) );
+        EXPECT( one.str() == two.str() );
+
+        EXPECT( 1 == run( { }, { "--jobs=0" }, os ) );
+    },
+
+    CASE( "Generators shrink toward simpler values [property]" )
+    {
+        std::vector<int> candidates;
+        auto collect = [&]( int x ) { candidates.push_back( x ); return false; };
+
+        EXPECT_NOT( gen::int_( -100, 100 ).shrink( 40, collect ) );
+        EXPECT( candidates == ( std::vector<int>{ 0, 20, 30, 35, 38, 39 } ) );
+
+        candidates.clear();
+        EXPECT_NOT( gen::int_( 5, 100 ).shrink( 5, collect ) );
+        EXPECT( candidates.empty() );
+
+        std::vector< std::vector<int> > vectors;
+        EXPECT_NOT( gen::vector( gen::int_( 0, 9 ) ).shrink( std::vector<int>{ 1, 2 }, [&]( std::vector<int> const & v ) { vectors.push_back( v ); return false; } ) );
+        EXPECT( vectors.front().empty() );
+        EXPECT( vectors.size() == 6u );
+    },
+
+    CASE( "Fuzz case runs the empty input or the corpus inputs without option --fuzz [fuzz]" )
+    {
+        test pass[] = {{ FUZZ_CASE( "P", data, size ) { EXPECT( size == 0u ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--pass" }, os ) );
+        EXPECT( std::string::npos != os.str().find( "passed: P: fuzz for empty input" ) );
+    },
+
+    CASE( "Option --fuzz=n saves a failing input that reproduces via --fuzz-corpus [commandline][fuzz]" )
+    {
+        test fail[] = {{ FUZZ_CASE( "F", data, size )
+        {
+            for ( std::size_t i = 0; i < size; ++i )
+                EXPECT( data[i] != 0x7f );
+        } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, { "--fuzz=10", "--fuzz-minimize" }, os ) );
+        EXPECT( std::string::npos != os.str().find( "failed: fuzz input (1 byte, run " ) );
+
+        const auto first = os.str().find( "saved as " ) + 9;
+        const text path  = os.str().substr( first, os.str().find( ")", first ) - first );
+
+        std::ostringstream os_corpus;
+
+        EXPECT( 1 == run( fail, { "--fuzz-corpus=" + path }, os_corpus ) );
+        EXPECT( std::string::npos != os_corpus.str().find( "failed: fuzz input (1 byte, " + path + "): F: data[i] != 0x7f for " ) );
+
+        EXPECT( 0 == std::remove( path.c_str() ) );
+        EXPECT( 1 == run( fail, { "--fuzz=0" }, os ) );
+    },
+
+    CASE( "Data case runs for each row and reports failing rows in table order [data]" )
+    {
+        test table[] = {{ DATA_CASE( "D", "lest_data_case.csv" )
+        {
+            EXPECT( row[0].as<int>() + row[1].as<int>() == row[2].as<int>() );
+        } }};
+
+        {
+            std::ofstream csv( "lest_data_case.csv" );
+            csv << "# a,b,sum\n1,2,3\n4,5,9\r\n\n7,8,16\n10,11,21\n5,x,5\n";
+        }
+
+        std::ostringstream os1;
+        std::ostringstream os3;
+
+        EXPECT( 1 == run( table, { "--pass" }, os1 ) );
+        EXPECT( 1 == run( table, { "--pass", "--jobs=3" }, os3 ) );
+        EXPECT( os1.str() == os3.str() );
+
+        EXPECT( std::string::npos != os1.str().find( "passed: D: row for line 2: 1,2,3" ) );
+        EXPECT( std::string::npos != os1.str().find( "failed (line 5: 7,8,16): D: row[0].as<int>() + row[1].as<int>() == row[2].as<int>() for 15 == 16" ) );
+        EXPECT( std::string::npos != os1.str().find( "(line 7: 5,x,5)" ) );
+        EXPECT( os1.str().find( "line 6" ) < os1.str().find( "line 7" ) );
+        EXPECT( std::string::npos != os1.str().find( "failed: data table (2 out of 5 rows failed): D: lest_data_case.csv" ) );
+
+        EXPECT( 0 == std::remove( "lest_data_case.csv" ) );
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( table, { }, os ) );
+        EXPECT( std::string::npos != os.str().find( "cannot read file 'lest_data_case.csv'" ) );
+    },
+
+    CASE( "Data case fields are views that convert to text and numbers [data]" )
+    {
+        test table[] = {{ DATA_CASE( "D", "lest_data_case.csv" )
+        {
+            EXPECT( row.size() == 4u );
+            EXPECT( row[0] == "a" );
+            EXPECT( row[1].str() == "b,\"c\"" );
+            EXPECT( row[2].as<double>() == approx( -2.5 ) );
+            EXPECT( row[3].empty() );
+            EXPECT_THROWS_AS( row[0].as<int>(), std::invalid_argument );
+            EXPECT_THROWS_AS( row.at( 4 ), std::out_of_range );
+        } }};
+
+        {
+            std::ofstream csv( "lest_data_case.csv" );
+            csv << "a,\"b,\"\"c\"\"\",-2.5,\n";
+        }
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( table, { }, os ) );
+        EXPECT( 0 == std::remove( "lest_data_case.csv" ) );
+    },
+
+    CASE( "Record case runs for each binary record [data]" )
+    {
+        struct pair_t { std::int32_t a, b; };
+
+        test table[] = {{ RECORD_CASE( "R", "lest_data_case.bin", pair_t ) { EXPECT( record.a < record.b ); } }};
+
+        {
+            const pair_t records[] = { { 1, 2 }, { 3, 4 }, { 6, 5 } };
+            std::ofstream bin( "lest_data_case.bin", std::ios::binary );
+            bin.write( reinterpret_cast<char const *>( records ), sizeof records );
+        }
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( table, { }, os ) );
+        EXPECT( std::string::npos != os.str().find( "failed (record 2): R: record.a < record.b for 6 < 5" ) );
+        EXPECT( std::string::npos != os.str().find( "(1 out of 3 rows failed)" ) );
+        EXPECT( 0 == std::remove( "lest_data_case.bin" ) );
+    },
+
     CASE( "Option --order=declared tests in source code order [commandline]" )
     {
         test pass[] = {{ CASE_E( "b" ) { ; } },
@@ -1103,6 +1920,215 @@ const lest::test specification[] =
         EXPECT( std::string::npos != os.str().find( "Error" ) );
     },
 
+    CASE( "Option --flaky-scan=n runs each test n times and lists the flaky ones [commandline]" )
+    {
+        std::atomic<int> runs( 0 );
+
+        test tests_[] = {
+            { CASE( "Pass" ) { EXPECT( true ); } },
+            { CASE( "Fail" ) { EXPECT( false ); } },
+            { CASE_ON( "Flaky", &runs ) { EXPECT( ++runs % 3 != 0 ); } },
+        };
+
+        std::ostringstream os;
+
+        EXPECT( 2 == run( tests_, { "--flaky-scan=6", "--jobs=2", "--flaky-list=lest_flaky.tsv" }, os ) );
+        EXPECT( runs == 6 );
+        EXPECT( std::string::npos != os.str().find( "passes   6/6 passed, median " ) );
+        EXPECT( std::string::npos != os.str().find( "fails    0/6 passed, median " ) );
+        EXPECT( std::string::npos != os.str().find( "flaky    4/6 passed, median " ) );
+        EXPECT( std::string::npos != os.str().find( "1 flaky and 1 failing out of 3 selected tests (6 runs each)" ) );
+
+        std::ifstream list( "lest_flaky.tsv" );
+        std::string header, line, rest;
+        std::getline( list, header );
+        std::getline( list, line );
+
+        EXPECT( line == "Flaky\t4\t6" );
+        EXPECT( ! std::getline( list, rest ) );
+
+        list.close();
+        EXPECT( 0 == std::remove( "lest_flaky.tsv" ) );
+    },
+
+    CASE( "Option --flaky-scan=n runs a test on one thread at a time and writes no list without flaky tests [commandline]" )
+    {
+        std::atomic<int> active( 0 ), overlap( 0 );
+
+        test tests_[] = {
+            { CASE_ON( "A", &active, &overlap ) { overlap += ( ++active > 1 ); std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) ); --active; } },
+            { CASE( "B" ) { EXPECT( true ); } },
+        };
+
+        std::remove( "flaky.tsv" );
+        std::ostringstream os;
+
+        EXPECT( 0 == run( tests_, { "--flaky-scan=8", "--jobs=4" }, os ) );
+        EXPECT( overlap == 0 );
+        EXPECT( std::string::npos != os.str().find( "0 flaky and 0 failing out of 2 selected tests (8 runs each)\n" ) );
+        EXPECT( ! std::ifstream( "flaky.tsv" ) );
+
+        os << 1.25;
+
+        EXPECT( std::string::npos != os.str().find( "each)\n1.25" ) );
+    },
+
+    CASE( "Option --flaky-scan=n tears down suite fixtures after their last selected user [commandline]" )
+    {
+        lest::fixture<int> answer( "answer", []() { return 42; } );
+
+        test users[] = {{ CASE_ON( "A [answer]", &answer ) { EXPECT( answer() == 42 ); } }};
+
+        // made by an enclosing run, so only finished() lets it go:
+
+        answer();
+
+        std::remove( "flaky.tsv" );
+        std::ostringstream os;
+
+        EXPECT( 0 == run( users, { "--flaky-scan=3" }, os ) );
+        EXPECT( ! answer.built() );
+    },
+
+    CASE( "Option --repeat-until-fail reports a token that --replay=token reruns [commandline]" )
+    {
+        int runs = 0;
+        text ran;
+
+        test tests_[] = {
+            { CASE_ON( "Other", &ran ) { ran += "o"; } },
+            { CASE_ON( "Flaky", &runs, &ran )
+            {
+                SETUP( "Context" ) {
+                    SECTION( "A" ) { ran += "A"; }
+                    SECTION( "B" ) {
+                        SECTION( "One" ) { ran += "1"; }
+                        SECTION( "Two" ) { ran += "2"; EXPECT( ++runs != 3 ); }
+                    }
+                }
+            } },
+        };
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( tests_, { "--repeat-until-fail" }, os ) );
+        EXPECT( ran == "oA12oA12oA12" );
+
+        const std::size_t pos = os.str().find( "Replay with option --replay=" );
+        const text token = os.str().substr( pos + 28, os.str().find( '\n', pos ) - pos - 28 );
+
+        EXPECT( token.substr( 0, 8 ) == "d-0-2-1-" );
+        EXPECT( token.substr( 16 ) == "-420054776f" );
+
+        runs = 0; ran.clear();
+
+        std::ostringstream replayed;
+
+        EXPECT( 1 == run( tests_, { "--replay=" + token }, replayed ) );
+        EXPECT( ran == "oA12oA12o2" );
+        EXPECT( std::string::npos != replayed.str().find( "1 out of 1 selected test failed." ) );
+
+        EXPECT( 1 == run( tests_, { "--replay=d-0-2-0-" + token.substr( 8 ) }, os ) );
+        EXPECT( std::string::npos != os.str().find( "Error: replay token doesn't match the tests" ) );
+
+        EXPECT( 1 == run( tests_, { "--replay=x-0-2" }, os ) );
+        EXPECT( std::string::npos != os.str().find( "Error: invalid token 'x-0-2' with option --replay" ) );
+    },
+
+    CASE( "Option --repeat-until-fail reports the path of the failing section with --jobs and --section-jobs [commandline]" )
+    {
+        test tests_[] = {{ CASE( "T" )
+        {
+            SETUP( "Context" ) {
+                SECTION( "A" ) { EXPECT( 1 == 1 ); }
+                SECTION( "B" ) { EXPECT( 1 == 2 ); }
+            }
+        } }};
+
+        std::ostringstream sequential;
+
+        EXPECT( 1 == run( tests_, { "--repeat-until-fail" }, sequential ) );
+
+        const auto token = sequential.str().substr( sequential.str().find( "Replay with option" ) );
+
+        for ( auto jobs : { "--jobs=2", "--section-jobs=2" } )
+        {
+            std::ostringstream os;
+
+            EXPECT( 1 == run( tests_, { "--repeat-until-fail", jobs }, os ) );
+            EXPECT( std::string::npos != os.str().find( token ) );
+        }
+    },
+
+#if lest_HAVE_POSIX
+    CASE( "Option --bisect=name finds the preceding tests that make the named test fail [commandline]" )
+    {
+        static int polluted = 0;
+
+        test tests_[] = {
+            { CASE( "A"        ) { } },
+            { CASE( "Pollute1" ) { ++polluted; } },
+            { CASE( "B"        ) { } },
+            { CASE( "C"        ) { EXPECT( false ); } },
+            { CASE( "Pollute2" ) { ++polluted; } },
+            { CASE( "D"        ) { } },
+            { CASE( "Victim"   ) { EXPECT( polluted < 2 ); } },
+        };
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( tests_, { "--bisect=Victim", "--jobs=3" }, os ) );
+        EXPECT( std::string::npos != os.str().find( "Victim: fails after 2 of the 6 preceding tests (" ) );
+        EXPECT( std::string::npos != os.str().find( "):\n  Pollute1\n  Pollute2\n" ) );
+        EXPECT( polluted == 0 );
+
+        EXPECT( 0 == run( tests_, { "--bisect=D" }, os ) );
+        EXPECT( std::string::npos != os.str().find( "D: passes after the 5 preceding tests" ) );
+
+        EXPECT( 1 == run( tests_, { "--bisect=C" }, os ) );
+        EXPECT( std::string::npos != os.str().find( "C: fails on its own" ) );
+
+        EXPECT( 1 == run( tests_, { "--bisect=Pollute" }, os ) );
+        EXPECT( std::string::npos != os.str().find( "Error: option --bisect: 2 selected tests match 'Pollute'" ) );
+    },
+#endif
+
+#if defined( __linux__ )
+    CASE( "Option --check-leaks fails tests that leave file descriptors or threads behind [commandline]" )
+    {
+        static int fd = -1;
+        static std::atomic<bool> done( false );
+        const int threads = lest::current_resources().threads;
+
+        test tests_[] = {
+            { CASE( "Closes" ) { ::close( ::open( "/dev/null", O_RDONLY ) ); } },
+            { CASE( "Joins"  ) { std::thread( []{} ).join(); } },
+            { CASE( "Opens"  ) { fd = ::open( "/dev/null", O_RDONLY ); } },
+            { CASE( "Detaches" ) { std::thread( []{ while ( ! done ) std::this_thread::yield(); } ).detach(); } },
+        };
+
+        std::ostringstream os;
+
+        EXPECT( 2 == run( tests_, { "--check-leaks" }, os ) );
+        EXPECT( std::string::npos != os.str().find( "lest:0: failed: leaked (fd " + to_string( fd ) + " -> /dev/null): Opens: 1 file descriptor" ) );
+        EXPECT( std::string::npos != os.str().find( "lest:0: failed: leaked: Detaches: 1 thread" ) );
+
+        ::close( fd ); done = true;
+
+        while ( lest::current_resources().threads > threads )
+            std::this_thread::yield();
+    },
+
+    CASE( "Option --check-leaks doesn't take a thread that was just joined for a leak [commandline]" )
+    {
+        test tests_[] = {{ CASE( "Joins" ) { std::thread( []{} ).join(); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( tests_, { "--check-leaks", "--repeat=200" }, os ) );
+    },
+#endif
+
     CASE( "Option --version is recognised [commandline]" )
     {
         std::ostringstream os;
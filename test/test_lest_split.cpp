@@ -0,0 +1,74 @@
+// Copyright 2013-2018 by Martin Moene
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Compiled with lest_CONFIG_SPLIT: this translation unit implements the runner
+// for the cases of test_lest_split_module.cpp.
+
+#define lest_CONFIG_IMPLEMENT  1
+
+#include "lest/lest.hpp"
+
+#ifdef __clang__
+# pragma clang diagnostic ignored "-Wmissing-braces"
+#elif defined __GNUC__
+# pragma GCC   diagnostic ignored "-Wmissing-braces"
+#endif
+
+// Without lest_FEATURE_FUZZ, _DATA and _PROCESS, lest doesn't include system
+// headers, so their names are free:
+
+static int close = 0;
+int access( int );
+
+lest::tests split_passing();
+lest::tests split_failing();
+
+const lest::test specification[] =
+{
+    CASE( "Split: a light translation unit runs its cases" )
+    {
+        std::ostringstream os;
+
+        EXPECT( 0 == lest::run( split_passing(), { "--pass" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "passed: Expression: a == b for { 1, 2, 3, } == { 1, 2, 3, }" ) );
+        EXPECT( std::string::npos != os.str().find( "passed: got exception: Exception: throw 42" ) );
+        EXPECT( std::string::npos != os.str().find( "passed: Setup: 6 == --i for 6 == 6" ) );
+        EXPECT( std::string::npos != os.str().find( "passed: Shared setup: v.size() == 2u for 2 == 2" ) );
+        EXPECT( std::string::npos != os.str().find( "for \"w\\t\" == \"w\\t\"" ) );
+        EXPECT( std::string::npos != os.str().find( "for 1 == 1 (ulp distance: 0, max: 4)" ) );
+    },
+
+    CASE( "Split: a light translation unit reports its failures" )
+    {
+        std::ostringstream os;
+
+        EXPECT( 1 == lest::run( split_failing(), {}, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: Failing: std::string( \"a\" ) == \"b\" for \"a\" == \"b\"" ) );
+    },
+
+    CASE( "Split: option --section selects a section of a light translation unit" )
+    {
+        std::ostringstream os;
+
+        EXPECT( 0 == lest::run( split_passing(), { "--pass", "--section=Left", "Setup" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "8 == ++i" ) );
+        EXPECT( std::string::npos == os.str().find( "6 == --i" ) );
+    },
+
+    CASE( "Split: names of system functions are free for the user" )
+    {
+        EXPECT( close == 0 );
+    },
+};
+
+int main( int argc, char * argv[] )
+{
+    return lest::run( specification, argc, argv );
+}
+
+// g++ -Wall -Wextra -std=c++11 -Dlest_CONFIG_SPLIT=1 -I../include -o test_lest_split.exe test_lest_split.cpp test_lest_split_module.cpp && test_lest_split
@@ -0,0 +1,80 @@
+// Copyright 2013-2018 by Martin Moene
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Compiled with lest_CONFIG_SPLIT: this translation unit only sees the test
+// macros and the decomposition, test_lest_split.cpp implements the runner.
+
+#include "lest/lest.hpp"
+
+#if ! lest_CONFIG_SPLIT || lest_HAVE_IMPLEMENTATION
+# error test_lest_split_module.cpp must be compiled with lest_CONFIG_SPLIT=1
+#endif
+
+#ifdef __clang__
+# pragma clang diagnostic ignored "-Wmissing-braces"
+#elif defined __GNUC__
+# pragma GCC   diagnostic ignored "-Wmissing-braces"
+#endif
+
+namespace {
+
+const lest::test passing[] =
+{
+    CASE( "Expression" )
+    {
+        std::vector<int> a{ 1, 2, 3 }, b{ 1, 2, 3 };
+
+        EXPECT(     a == b );
+        EXPECT_NOT( a != b );
+        EXPECT( 1.0 == lest::approx( 1.0 ) );
+        EXPECT_RANGE_EQ( a, b );
+    },
+
+    CASE( "Exception" )
+    {
+        EXPECT_THROWS( throw 42 );
+        EXPECT_THROWS_AS( throw std::runtime_error( "" ), std::runtime_error );
+        EXPECT_NO_THROW( lest::is_true( true ) );
+    },
+
+    CASE( "Setup" )
+    {
+        SETUP( "Context" )
+        {
+            int i = 7;
+
+            SECTION( "Left" ) { EXPECT( 8 == ++i ); }
+            SECTION( "Right") { EXPECT( 6 == --i ); }
+        }
+    },
+
+    CASE( "Shared setup" )
+    {
+        SETUP_SHARED( "Context", v, []() { return std::vector<int>{ 1, 2 }; } )
+        {
+            SECTION( "Grow" ) { v.push_back( 3 ); EXPECT( v.size() == 3u ); }
+            SECTION( "Fresh") { EXPECT( v.size() == 2u ); }
+        }
+    },
+
+    CASE( "Formatting" )
+    {
+        EXPECT( std::wstring( L"w\t" ) == L"w\t" );
+        EXPECT( 1.0 == lest::approx( 1.0 ).ulps( 4 ) );
+    },
+};
+
+const lest::test failing[] =
+{
+    CASE( "Failing" )
+    {
+        EXPECT( std::string( "a" ) == "b" );
+    },
+};
+
+} // anonymous namespace
+
+lest::tests split_passing() { return lest::tests( std::begin( passing ), std::end( passing ) ); }
+lest::tests split_failing() { return lest::tests( std::begin( failing ), std::end( failing ) ); }